@@ -10,6 +10,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* POSIX wants this to be declared by whoever uses it */
+extern char **environ;
+
 const char *errors[] = {
   /*CA_ALLOK    */ "Everything is fine",
   /*CA_ERROR    */ "An Error occurred",
@@ -64,8 +67,9 @@ checkarg_new(const char *appname, const char *desc, const char *appendix) {
   }
 
   /* just in case, zeroing the struct should have already done this */
-  priv->pos_args = NULL;
-  priv->callname = NULL;
+  priv->pos_args   = NULL;
+  priv->callname   = NULL;
+  priv->generation = 1;
 
   return ret;
 
@@ -82,12 +86,13 @@ checkarg_free(CheckArg *ca) {
     free(ca->p->descr);
     free(ca->p->appendix);
     free(ca->p->usage_line);
-    free(ca->p->next_is_val_of);
     free(ca->p->posarg_help_descr);
     free(ca->p->posarg_help_usage);
-    free(ca->p->callname);
+    free(ca->p->env_prefix);
 
     /* "arrays" and lists */
+    free(ca->p->env_opts);
+    free(ca->p->prefix_opts);
     pos_args_free(ca->p->pos_args);
     valid_args_free(ca->p->valid_args);
 
@@ -148,75 +153,147 @@ checkarg_add_autohelp(CheckArg *ca) {
 
 void
 checkarg_reset(CheckArg *ca) {
-  free(ca->p->callname);
   ca->p->callname = NULL;
 
-  ca->p->pos_arg_sep = 0;
-  free(ca->p->pos_args);
-  ca->p->pos_args = NULL;
+  /* keep the pos_args array for the next parse */
+  ca->p->pos_arg_sep    = 0;
+  ca->p->pos_args_count = 0;
 
-  free(ca->p->next_is_val_of);
   ca->p->next_is_val_of = NULL;
 
-  Opt *it = ca->p->valid_args;
-  if (it) {
-    do {
-      free(it->value);
-      it->value = NULL;
-    }
-    while ((it = it->next));
+  ca->p->argv     = NULL;
+  ca->p->argv_end = 0;
+  ca->p->consumed = 0;
+
+  /* values of the last parse become stale by starting a new generation,
+   * only if it wraps around, the stamps need to be cleared */
+  if (++ca->p->generation == 0) {
+    Opt *it;
+    for (it = ca->p->valid_args; it; it = it->next) it->seen = it->env_seen = 0;
+    ca->p->generation = 1;
   }
 
   ca->p->cleared = 1;
 }
 
-int
-checkarg_parse(CheckArg *ca, const int argc, char **argv) {
-  int ret = CA_ALLOK;
-  int i;
-
+/* everything before the args of argv are parsed */
+static int
+parse_begin(CheckArg *ca, const int argc, char **argv, uint8_t collect_pos_args) {
   if (argc < 1) {
     fprintf(stderr, "argc must be at least 1");
-    ret = CA_ERROR;
-    goto error;
+    return CA_ERROR;
   }
   if (!argv) {
     fprintf(stderr, "argv must not be NULL");
-    ret = CA_ERROR;
-    goto error;
+    return CA_ERROR;
   }
   if (!argv[0]) {
     fprintf(stderr, "argv must have at least one element");
-    ret = CA_ERROR;
-    goto error;
+    return CA_ERROR;
   }
 
   if (!ca->p->cleared) { checkarg_reset(ca); }
   ca->p->cleared = 0;
 
-  ca->p->callname = strdup(argv[0]);
-  if (!ca->p->callname) {
-    ret = CA_ALLOC_ERR;
-    goto error;
-  }
+  CA_PROBE(parse__start, argc, argv);
 
-  /* alloc a bit too much and shrink it to real size in one go later */
-  ca->p->pos_args = (const char **)malloc(argc * sizeof(char *));
-  if (!ca->p->pos_args) {
-    ret = CA_ALLOC_ERR;
-    goto error;
+  ca->p->callname = argv[0];
+  ca->p->argv     = argv;
+  ca->p->argv_end = argc;
+
+  /* alloc a bit too much, so appending never needs to check the size */
+  if (collect_pos_args && ca->p->pos_args_size < (size_t)argc) {
+    const char **tmp = (const char **)realloc(ca->p->pos_args, argc * sizeof(char *));
+    if (!tmp) return CA_ALLOC_ERR;
+    ca->p->pos_args      = tmp;
+    ca->p->pos_args_size = argc;
   }
+  return CA_ALLOK;
+}
+
+int
+checkarg_parse(CheckArg *ca, const int argc, char **argv) {
+  int i;
+  int ret = parse_begin(ca, argc, argv, !ca->p->lazy_pos_args);
+  if (ret != CA_ALLOK) goto error;
 
   for (i = 1; i < argc; ++i) {
     ret = checkarg_arg(ca, argv[i]);
-    if (ret != CA_ALLOK) goto error;
+    if (ret != CA_ALLOK) {
+      ca->p->argv_end = i; /* positional args after an error are not parsed */
+      goto error;
+    }
+  }
+
+  if (ca->p->next_is_val_of) ret = ca_error(CA_MISSVAL, ": %s!", argv[argc - 1]);
+  if (ret == CA_ALLOK) apply_env(ca);
+
+error:
+  CA_PROBE(parse__end, ret);
+  return ret;
+}
+
+/* whether arg is an option checkarg_arg() would not fail on as unknown */
+static uint8_t
+is_known_option(CheckArg *ca, const char *arg) {
+  const char *it;
+  Opt *opt;
+
+  if (arg[0] != '-' || !arg[1]) return 0;
+  if (arg[1] == '-') return valid_args_find_n(ca, arg + 2, scan_eq(arg + 2) - (arg + 2)) != NULL;
+
+  for (it = arg + 1; *it; ++it) {
+    opt = valid_args_find_sopt(ca, *it);
+    if (!opt) return 0;
+    if (opt->value_type != CA_VT_NONE) return 1; /* the rest is its value */
+  }
+  return 1;
+}
+
+/* Like checkarg_parse(), but known options and their values are removed from argv,
+ * unknown options and positional args are kept in order and passed over.
+ * argc is updated and argv[argc] set to NULL, so argv can be passed to execv(),
+ * argv must have room for that, like the one given to main() has.
+ * Positional args are always collected, even if lazy, as argv changes,
+ * checkarg_pos_args_next() then iterates the collected ones.
+ * If parsing fails, argv keeps everything from the failing arg on. */
+int
+checkarg_parse_consume(CheckArg *ca, int *argc, char **argv) {
+  int i, kept = 1;
+  int ret = parse_begin(ca, *argc, argv, 1);
+  if (ret != CA_ALLOK) goto error;
+  ca->p->consumed = 1;
+
+  for (i = 1; i < *argc; ++i) {
+    char *arg = argv[i];
+    /* values are removed with their option, positional args and '--' are kept */
+    uint8_t keep = !ca->p->next_is_val_of;
+
+    if (keep && !ca->p->pos_arg_sep && (classify_arg(ca, arg) & AK_OPTION)) {
+      /* leave unknown options for whoever gets argv next */
+      if (!is_known_option(ca, arg)) {
+        argv[kept++] = arg;
+        continue;
+      }
+      keep = 0;
+    }
+
+    ret = checkarg_arg(ca, arg);
+    if (ret != CA_ALLOK) break;
+    if (keep) argv[kept++] = arg;
   }
 
-  if (ca->p->next_is_val_of) { return ca_error(CA_MISSVAL, ": %s!", argv[argc - 1]); }
+  /* on error, the rest stays */
+  for (; i < *argc; ++i) argv[kept++] = argv[i];
+  *argc       = kept;
+  argv[*argc] = NULL;
 
-  /* TODO: resize pos_args */
+  if (ret == CA_ALLOK && ca->p->next_is_val_of)
+    ret = ca_error(CA_MISSVAL, ": --%s!", ca->p->next_is_val_of->lopt);
+  if (ret == CA_ALLOK) apply_env(ca);
 
 error:
+  CA_PROBE(parse__end, ret);
   return ret;
 }
 
@@ -270,10 +347,38 @@ checkarg_pos_args_count(CheckArg *ca) {
   return ca->p->pos_args_count;
 }
 
+void
+checkarg_set_lazy_pos_args(CheckArg *ca, uint8_t lazy) {
+  ca->p->lazy_pos_args = lazy;
+}
+
+/* returns the next positional arg after the one it points to, NULL at the end,
+ * works with or without lazy pos args, as long as the parsed argv is valid */
+const char *
+checkarg_pos_args_next(CheckArg *ca, CheckArgPosIter *it) {
+  if (ca->p->consumed) {
+    /* argv changed, iterate the collected ones, index 1 is the first */
+    if ((size_t)it->index > ca->p->pos_args_count) return NULL;
+    return ca->p->pos_args[it->index++ - 1];
+  }
+  while (it->index < ca->p->argv_end) {
+    const char *arg = ca->p->argv[it->index++];
+    int kind;
+
+    if (it->sep) return arg;
+    kind = classify_arg(ca, arg);
+    if (kind == AK_POSITIONAL) return arg;
+    if (kind & AK_SEPARATOR) it->sep = 1;
+    if (kind & AK_CONSUMES) ++it->index; /* skip the value */
+  }
+  return NULL;
+}
+
 const char *
 checkarg_value(CheckArg *ca, const char *key) {
   Opt *opt = valid_args_find(ca, key);
-  if (opt) return opt->value;
+  if (opt && opt->seen == ca->p->generation)
+    return opt->value_type != CA_VT_NONE ? opt->value : "";
   return NULL;
 }
 
@@ -281,10 +386,63 @@ uint8_t
 checkarg_isset(CheckArg *ca, const char *key) {
   Opt *opt = valid_args_find(ca, key);
   /* find returns NULL if not found */
-  if (opt) return opt->value == NULL ? 0 : 1;
+  if (opt) return opt->seen == ca->p->generation;
   return 0;
 }
 
+/* binds lopt to the environment variable var, replacing what was bound before,
+ * the value of var is used after parsing, if lopt was not given */
+int
+checkarg_bind_env(CheckArg *ca, const char *lopt, const char *var) {
+  Opt *opt = valid_args_find(ca, lopt);
+  char *env;
+  size_t i;
+  if (!opt) return CA_INVOPT;
+
+  env = strdup(var);
+  if (!env) return CA_ALLOC_ERR;
+
+  /* a variable is bound to one option only */
+  for (i = 0; i < ca->p->env_opts_count;) {
+    Opt *other = ca->p->env_opts[i];
+    if (other == opt || strcmp(other->env, var) != 0) {
+      ++i;
+      continue;
+    }
+    free(other->env);
+    other->env         = NULL;
+    ca->p->env_opts[i] = ca->p->env_opts[--ca->p->env_opts_count];
+  }
+
+  if (!opt->env) {
+    Opt **tmp = (Opt **)realloc(
+      ca->p->env_opts, (ca->p->env_opts_count + 1) * sizeof(Opt *));
+    if (!tmp) {
+      free(env);
+      return CA_ALLOC_ERR;
+    }
+    ca->p->env_opts                          = tmp;
+    ca->p->env_opts[ca->p->env_opts_count++] = opt;
+  }
+  free(opt->env);
+  opt->env               = env;
+  ca->p->env_opts_sorted = 0;
+  return CA_ALLOK;
+}
+
+/* binds every option to a variable of its name prefixed, NULL disables it,
+ * those bound by checkarg_bind_env() take precedence */
+int
+checkarg_set_env_prefix(CheckArg *ca, const char *prefix) {
+  free(ca->p->env_prefix);
+  ca->p->env_prefix = NULL;
+  if (!prefix || !*prefix) return CA_ALLOK;
+
+  ca->p->env_prefix = strdup(prefix);
+  if (!ca->p->env_prefix) return CA_ALLOC_ERR;
+  return CA_ALLOK;
+}
+
 const char *
 checkarg_str_err(const int errno) {
   return errors[errno];
@@ -410,7 +568,7 @@ checkarg_autohelp(CheckArg *ca) {
      *
      * same with the distance between cur and msg, (the current length of the message)
      * it shall not exceed malloced_len */
-    assert(msglen > 0 && (cur - msg < malloced_len));
+    assert(msglen > 0 && ((size_t)(cur - msg) < malloced_len));
   }
   while ((it = it->next));
 
@@ -444,6 +602,8 @@ checkarg_show_help(CheckArg *ca) {
 
 int
 checkarg_show_autohelp(CheckArg *ca, const char *larg, const char *val) {
+  (void)larg;
+  (void)val;
   checkarg_show_help(ca);
   exit(0); /* always exit after showing help */
 }
@@ -493,12 +653,8 @@ clean:
 static void
 opt_free(Opt *o) {
   if (o) {
-    if (o->value_type != CA_VT_NONE) {
-      // value is either NULL if opt was not parsed or:
-      // if value_type > 0, value may have been strdup'ed and must be free'd
-      // otherwise points to the literal "x", which is static
-      free(o->value);
-    }
+    /* value points into argv, nothing to free there */
+    free(o->env);
     free(o->value_name);
     free(o->help);
     free(o->lopt);
@@ -509,6 +665,7 @@ opt_free(Opt *o) {
 static int
 ca_error(int eno, const char *fmt, ...) {
   va_list al;
+  CA_PROBE(error, eno);
   va_start(al, fmt);
 
   fprintf(stderr, "Error: %s", errors[eno]);
@@ -534,6 +691,7 @@ valid_args_free(Opt *vaptr) {
 
 static int
 valid_args_insert(CheckArg *ca, Opt *opt) {
+  ca->p->prefix_opts_valid = 0;
   /* this inserts a new opt before the one that has a higher sort order
    * that way the list stays sorted, insertion is now O(n), though
    * except when inserting in reverse sort order, then its O(1) */
@@ -602,20 +760,136 @@ valid_args_append(CheckArg *ca, Opt *opt) {
 /* sadly O(n), returns NULL if not found  */
 static Opt *
 valid_args_find(CheckArg *ca, const char *lopt) {
-  Opt *it = ca->p->valid_args;
-  do {
-    if (strcmp(it->lopt, lopt) == 0) return it;
+  return valid_args_find_n(ca, lopt, strlen(lopt));
+}
+
+/* same, but lopt does not need to be terminated after len chars */
+static Opt *
+valid_args_find_n(CheckArg *ca, const char *lopt, size_t len) {
+  Opt *it;
+  for (it = ca->p->valid_args; it; it = it->next) {
+    if (strncmp(it->lopt, lopt, len) == 0 && !it->lopt[len]) return it;
   }
-  while (it && (it = it->next));
   return NULL;
 }
 
+/* returns a pointer to the first '=' in str, or to its terminating '\0'.
+ * The C library's strcspn() is vectorized, but never reads past the '\0'. */
+static const char *
+scan_eq(const char *str) {
+  return str + strcspn(str, "=");
+}
+
+/* (re)builds the index of prefix_opts_find(), once per set of options */
+static int
+prefix_opts_build(CheckArg *ca) {
+  size_t count = 0;
+  Opt *it, **tmp;
+  for (it = ca->p->valid_args; it; it = it->next) ++count;
+
+  tmp = (Opt **)realloc(ca->p->prefix_opts, (count ? count : 1) * sizeof(Opt *));
+  if (!tmp) return CA_ALLOC_ERR;
+  ca->p->prefix_opts       = tmp;
+  ca->p->prefix_opts_count = 0;
+  /* valid_args_insert() keeps them sorted by strcmp() already */
+  for (it = ca->p->valid_args; it; it = it->next)
+    ca->p->prefix_opts[ca->p->prefix_opts_count++] = it;
+  ca->p->prefix_opts_valid = 1;
+  return CA_ALLOK;
+}
+
+/* finds the option output-format for OUTPUT_FORMAT, name is not terminated,
+ * a binary search of the index for name lower-cased, with '-' for '_' */
+static Opt *
+prefix_opts_find(CheckArg *ca, const char *name, size_t len) {
+  size_t lo = 0, hi = ca->p->prefix_opts_count, i;
+  while (lo < hi) {
+    size_t mid       = lo + (hi - lo) / 2;
+    const char *lopt = ca->p->prefix_opts[mid]->lopt;
+    int cmp          = 0;
+    for (i = 0; i < len && !cmp; ++i) {
+      int c = name[i] == '_' ? '-' : tolower((unsigned char)name[i]);
+      cmp   = (unsigned char)lopt[i] - c; /* ends at lopt's '\0' */
+    }
+    if (cmp == 0) {
+      if (!lopt[len]) return ca->p->prefix_opts[mid];
+      cmp = 1; /* lopt is longer */
+    }
+    if (cmp < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return NULL;
+}
+
+static int
+compare_env(const void *a, const void *b) {
+  return strcmp((*(Opt *const *)a)->env, (*(Opt *const *)b)->env);
+}
+
+/* binary search of the bound variables, name is not terminated */
+static Opt *
+env_opts_find(CheckArg *ca, const char *name, size_t len) {
+  size_t lo = 0, hi = ca->p->env_opts_count;
+  while (lo < hi) {
+    size_t mid      = lo + (hi - lo) / 2;
+    const char *env = ca->p->env_opts[mid]->env;
+    int cmp         = strncmp(env, name, len);
+    if (cmp == 0) {
+      if (!env[len]) return ca->p->env_opts[mid];
+      cmp = 1; /* env is longer */
+    }
+    if (cmp < 0) lo = mid + 1;
+    else hi = mid;
+  }
+  return NULL;
+}
+
+/* takes the values of options not given from the environment, in a single pass
+ * over it, however many options and variables there are */
+static void
+apply_env(CheckArg *ca) {
+  unsigned gen      = ca->p->generation;
+  size_t prefix_len = ca->p->env_prefix ? strlen(ca->p->env_prefix) : 0;
+  char **env;
+
+  if (!ca->p->env_opts_count && !prefix_len) return;
+  if (!ca->p->env_opts_sorted) {
+    qsort(ca->p->env_opts, ca->p->env_opts_count, sizeof(Opt *), compare_env);
+    ca->p->env_opts_sorted = 1;
+  }
+  /* without memory for the index, prefixed variables are ignored */
+  if (prefix_len && !ca->p->prefix_opts_valid && prefix_opts_build(ca) != CA_ALLOK)
+    prefix_len = 0;
+
+  for (env = environ; env && *env; ++env) {
+    const char *eq = scan_eq(*env);
+    size_t len     = eq - *env;
+    uint8_t bound  = 0;
+    Opt *opt;
+    if (!*eq) continue;
+
+    opt = env_opts_find(ca, *env, len);
+    if (opt) bound = 1;
+    else if (
+      prefix_len && len > prefix_len && strncmp(*env, ca->p->env_prefix, prefix_len) == 0)
+      opt = prefix_opts_find(ca, *env + prefix_len, len - prefix_len);
+    if (!opt) continue;
+
+    /* the command line wins, and a bound variable over a prefixed one */
+    if (opt->seen == gen && (opt->env_seen != gen || !bound)) continue;
+    if (opt->value_type == CA_VT_NONE && (!eq[1] || strcmp(eq + 1, "0") == 0)) continue;
+    opt->value    = eq + 1;
+    opt->seen     = gen;
+    opt->env_seen = gen;
+  }
+}
+
 static Opt *
 valid_args_find_sopt(CheckArg *ca, char sopt) {
-  Opt *it = ca->p->valid_args;
-  do
+  Opt *it;
+  for (it = ca->p->valid_args; it; it = it->next) {
     if (it->sopt == sopt) return it;
-  while (it && (it = it->next));
+  }
   return NULL;
 }
 
@@ -625,20 +899,13 @@ checkarg_arg(CheckArg *ca, const char *arg) {
     /* if the separator '--' was given, all following args are positional */
 
     if (ca->p->next_is_val_of) {
-      /* _next_val_of should be an lopt with value */
-      int ret = 0;
-
-      Opt *opt = valid_args_find(ca, ca->p->next_is_val_of);
-      if (opt->value)
-        free(opt->value); /* in case someone specifies an option with value twice */
-      opt->value = strdup(arg);
-      if (!opt->value) /* malloc failed */
-        return ca_error(CA_ALLOC_ERR, "!");
-
-      ret = call_cb(ca, opt);
-      free(ca->p->next_is_val_of);
+      /* _next_val_of should be an opt with value */
+      Opt *opt = ca->p->next_is_val_of;
+
+      opt->value            = arg;
+      opt->seen             = ca->p->generation;
       ca->p->next_is_val_of = NULL;
-      return ret;
+      return call_cb(ca, opt);
     }
 
     if (arg[0] == '-') {                         /* it's an option */
@@ -652,16 +919,42 @@ checkarg_arg(CheckArg *ca, const char *arg) {
   }
 
   /* it's a positional arg */
-  pos_args_append(ca, arg);
+  if (!ca->p->lazy_pos_args || ca->p->consumed) pos_args_append(ca, arg);
   return CA_ALLOK;
 }
 
+/* this must match what checkarg_arg() and friends do */
+static int
+classify_arg(CheckArg *ca, const char *arg) {
+  const char *end, *it;
+  Opt *opt;
+
+  if (arg[0] != '-') return AK_POSITIONAL;
+
+  if (arg[1] == '-') {
+    if (!arg[2]) return AK_SEPARATOR;
+    end = scan_eq(arg + 2);
+    if (*end == '=') return AK_OPTION;
+    opt = valid_args_find_n(ca, arg + 2, end - (arg + 2));
+    if (opt && opt->value_type != CA_VT_NONE) return AK_OPTION | AK_CONSUMES;
+    return AK_OPTION;
+  }
+
+  for (it = arg + 1; *it; ++it) {
+    opt = valid_args_find_sopt(ca, *it);
+    if (!opt) break; /* an error, nothing is consumed */
+    if (opt->value_type != CA_VT_NONE) {
+      /* the remainder is the value, if there is one */
+      return it[1] ? AK_OPTION : AK_OPTION | AK_CONSUMES;
+    }
+  }
+  return AK_OPTION;
+}
+
 static int
 checkarg_arg_long(CheckArg *ca, const char *lopt) {
-  char *real_opt, *value;
-  char *it;
+  const char *end, *value;
   Opt *opt;
-  int ret = 0;
 
   if (!*lopt) {
     /* if '--' was given, lopt is an empty string */
@@ -669,65 +962,36 @@ checkarg_arg_long(CheckArg *ca, const char *lopt) {
     return CA_ALLOK;
   }
 
-  value    = NULL;
-  real_opt = strdup(lopt);
-  if (!real_opt) return ca_error(CA_ALLOC_ERR, "!");
-
-  it = real_opt;
-  while (*it && *it != '=') ++it;
-  /* iterated to either the position of the first '=' or the end of the string */
-
-  if (*it == '=') { /* if we're at an '=', split the value off */
-    value = it + 1; /* points to the part after the equal */
-    *it   = 0;
-    /* mark the end of the option with '\0' instead of '=' so it'll become a separate
-     * c-str, real_opt should now contain the option only */
-  }
+  end = scan_eq(lopt);
+  /* end is either the position of the first '=' or the end of the string,
+   * the option is everything before it, the value everything after an '=' */
+  value = *end == '=' ? end + 1 : NULL;
 
-  opt = valid_args_find(ca, real_opt);
+  opt = valid_args_find_n(ca, lopt, end - lopt);
   if (opt) {
+    CA_PROBE(option__match, opt->lopt, 0);
     if (opt->value_type != CA_VT_NONE && value) {
-      if (opt->value)
-        free(opt->value); /* in case someone specifies an option with value twice */
-      opt->value = strdup(value);
-      if (!opt->value) goto alloc_error;
+      opt->value = value; /* points into lopt */
+      opt->seen  = ca->p->generation;
     }
     else if (opt->value_type != CA_VT_NONE) {
-      ca->p->next_is_val_of = strdup(real_opt);
-      if (!ca->p->next_is_val_of) goto alloc_error;
+      ca->p->next_is_val_of = opt;
     }
     else if (value) { /* unexpected value given */
-      goto invval_error;
+      return ca_error(CA_INVVAL, ": --%.*s!", (int)(end - lopt), lopt);
     }
     else {
-      opt->value = "x"; /* mark option as seen, any value except NULL is ok here */
+      opt->seen = ca->p->generation;
     }
 
-    if (opt->value_type == CA_VT_NONE || value) {
-      ret = call_cb(ca, opt);
-      free(real_opt);
-      return ret;
-    }
-    free(real_opt);
+    if (opt->value_type == CA_VT_NONE || value) return call_cb(ca, opt);
     return CA_ALLOK;
   }
 
   /* else: no valid arg found -> invarg */
-  ret = ca_error(CA_INVOPT, ": --%s!", real_opt);
-  free(real_opt);
-  return ret;
-
-invval_error:
-  ret = ca_error(CA_INVVAL, ": --%s!", real_opt);
-  free(real_opt);
-  return ret;
-
-alloc_error:
-  free(real_opt);
-  return ca_error(CA_ALLOC_ERR, "!");
+  return ca_error(CA_INVOPT, ": --%.*s!", (int)(end - lopt), lopt);
 }
 
-
 static int
 checkarg_arg_short(CheckArg *ca, const char *args) {
   const char *it;
@@ -737,25 +1001,23 @@ checkarg_arg_short(CheckArg *ca, const char *args) {
   for (it = args; *it; ++it) {
     opt = valid_args_find_sopt(ca, *it);
     if (opt) { /* short option found */
+      CA_PROBE(option__match, opt->lopt, *it);
       if (opt->value_type != CA_VT_NONE) {
         if (*(++it)) { /* there's a remainder, assign it as value */
-          if (opt->value)
-            free(opt->value); /* in case someone specifies an option with value twice */
-          opt->value = strdup(it);
-          if (!opt->value) goto alloc_error;
+          opt->value = it;
+          opt->seen  = ca->p->generation;
 
           ret = call_cb(ca, opt);
           if (ret != CA_ALLOK) return ret;
         }
         else {
-          ca->p->next_is_val_of = strdup(opt->lopt);
-          if (!ca->p->next_is_val_of) goto alloc_error;
+          ca->p->next_is_val_of = opt;
         }
         return CA_ALLOK; /* we're done here */
       }
       else {
-        opt->value = "x"; /* any value except NULL is ok here */
-        ret        = call_cb(ca, opt);
+        opt->seen = ca->p->generation;
+        ret       = call_cb(ca, opt);
         if (ret != CA_ALLOK) return ret;
       }
     }
@@ -764,15 +1026,16 @@ checkarg_arg_short(CheckArg *ca, const char *args) {
     }
   }
   return CA_ALLOK;
-
-alloc_error:
-  return ca_error(CA_ALLOC_ERR, "!");
 }
 
 static int
 call_cb(CheckArg *ca, Opt *opt) {
   if (opt->cb) {
-    int ret = opt->cb(ca, opt->lopt, opt->value);
+    const char *value = opt->value_type != CA_VT_NONE ? opt->value : "";
+    int ret;
+    CA_PROBE(callback__entry, opt->lopt);
+    ret = opt->cb(ca, opt->lopt, value);
+    CA_PROBE(callback__return, opt->lopt, ret);
     if (ret != CA_ALLOK) { return ca_error(CA_CALLBACK, ": %d!", ret); }
   }
   return CA_ALLOK;
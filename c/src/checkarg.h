@@ -9,13 +9,23 @@
 
 typedef struct _CheckArg CheckArg;
 typedef struct _CheckArgPrivate CheckArgPrivate;
+/* called with the long option and its value,
+ * which is "" for options without a value */
 typedef int (*CheckArgFP)(CheckArg *, const char *, const char *);
 typedef CheckArg *CheckArgPtr;
+typedef struct _CheckArgPosIter CheckArgPosIter;
 
 struct _CheckArg {
   CheckArgPrivate *p;
 };
 
+/* state of checkarg_pos_args_next(), start with CHECKARG_POS_ITER_INIT */
+struct _CheckArgPosIter {
+  int index;   /* next argv index to look at */
+  uint8_t sep; /* '--' was passed */
+};
+#define CHECKARG_POS_ITER_INIT {1, 0}
+
 CheckArg *checkarg_new(const char *appname, const char *desc, const char *appendix);
 
 void checkarg_free(CheckArg *);
@@ -40,18 +50,38 @@ int checkarg_add_autohelp(CheckArg *);
 
 void checkarg_reset(CheckArg *);
 int checkarg_parse(CheckArg *, const int argc, char **argv);
+/* removes known options and their values from argv, see checkarg.c */
+int checkarg_parse_consume(CheckArg *, int *argc, char **argv);
 
 int checkarg_set_posarg_help(CheckArg *, const char *usage, const char *descr);
 int checkarg_set_usage_line(CheckArg *, const char *arg);
 
+/* callname, positional args and values are not copied, they point into the
+ * argv given to checkarg_parse(), so they're valid as long as that argv is
+ * and until the next parse */
 const char *checkarg_argv0(CheckArg *);
 const char *checkarg_callname(CheckArg *);
 const char **checkarg_pos_args(CheckArg *);
 size_t checkarg_pos_args_count(CheckArg *);
 
+/* with lazy pos args, checkarg_parse() does not collect positional args,
+ * checkarg_pos_args_next() finds them one by one in argv instead */
+void checkarg_set_lazy_pos_args(CheckArg *, uint8_t lazy);
+const char *checkarg_pos_args_next(CheckArg *, CheckArgPosIter *);
+
+/* points into argv like the callname, "" for options without a value */
 const char *checkarg_value(CheckArg *, const char *);
 uint8_t checkarg_isset(CheckArg *, const char *);
 
+/* options not given on the command line take their values from environment
+ * variables, bound one by one or by a prefix, like APP_ for --output-format
+ * from APP_OUTPUT_FORMAT. Values then point into the environment.
+ * With a prefix, the rest of a variable's name is lower-cased and '_' taken
+ * as '-', so APP_Output_Format works too, but options with upper-case
+ * letters in their long name have to be bound one by one. */
+int checkarg_bind_env(CheckArg *, const char *lopt, const char *var);
+int checkarg_set_env_prefix(CheckArg *, const char *prefix);
+
 const char *checkarg_str_err(const int errno);
 
 char *checkarg_usage(CheckArg *);
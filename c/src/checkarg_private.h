@@ -7,6 +7,14 @@
 #include "checkarg.h"
 #include "config.h"
 
+/* static tracepoints for perf and bpftrace, a no-op without sys/sdt.h */
+#ifdef HAS_SYS_SDT
+#include <sys/sdt.h>
+#define CA_PROBE(...) STAP_PROBEV(checkarg, __VA_ARGS__)
+#else
+#define CA_PROBE(...) ((void)0)
+#endif
+
 typedef struct _Opt Opt;
 struct _Opt {
   uint8_t value_type;
@@ -14,8 +22,11 @@ struct _Opt {
   char *lopt;
   char *help;
   CheckArgFP cb;
-  char *value;
+  const char *value; /* points into the argv given to checkarg_parse() */
   char *value_name;
+  unsigned seen; /* generation of the parse the option was given in */
+  char *env;     /* the variable bound by checkarg_bind_env() */
+  unsigned env_seen; /* generation of the parse its value came from env in */
   Opt *next;
 };
 
@@ -25,19 +36,49 @@ struct _CheckArgPrivate {
   Opt *valid_args_last;
   const char **pos_args;
   size_t pos_args_count;
+  size_t pos_args_size; /* allocated size of pos_args, kept between parses */
 
   uint8_t pos_arg_sep;
   uint8_t cleared;
+  /* bumped by checkarg_reset(), an option is set if its seen equals this */
+  unsigned generation;
+
+  char *appname, *descr, *appendix, *usage_line, *posarg_help_usage, *posarg_help_descr;
+  Opt *next_is_val_of;
+  const char *callname; /* argv[0] given to checkarg_parse() */
+
+  uint8_t lazy_pos_args;
+  char **argv;  /* given to checkarg_parse() */
+  int argv_end; /* index of the first arg not parsed */
+  /* argv is compacted by checkarg_parse_consume(), so pos args are collected */
+  uint8_t consumed;
+
+  /* options bound to environment variables, sorted by variable when parsing */
+  Opt **env_opts;
+  size_t env_opts_count;
+  uint8_t env_opts_sorted;
+  char *env_prefix;
+  /* every option sorted by its long name, for prefixed variables,
+   * built when parsing after options were added */
+  Opt **prefix_opts;
+  size_t prefix_opts_count;
+  uint8_t prefix_opts_valid;
+};
 
-  char *appname, *descr, *appendix, *usage_line, *posarg_help_usage, *posarg_help_descr,
-    *next_is_val_of;
-  char *callname;
+/* what checkarg_arg() does with an arg, see classify_arg() */
+enum ArgKind {
+  AK_POSITIONAL = 0,
+  AK_OPTION     = 1,
+  AK_CONSUMES   = 2, /* the next arg is its value */
+  AK_SEPARATOR  = 4,
 };
 
 
 static int checkarg_arg(CheckArg *, const char *arg);
 static int checkarg_arg_short(CheckArg *, const char *arg);
 static int checkarg_arg_long(CheckArg *, const char *arg);
+static int classify_arg(CheckArg *, const char *arg);
+static uint8_t is_known_option(CheckArg *, const char *arg);
 
 static Opt *opt_new(
   const char sopt, const char *lopt, CheckArgFP cb, const char *help,
@@ -51,7 +92,13 @@ static int valid_args_insert(CheckArg *, Opt *opt);
 static int valid_args_append(CheckArg *, Opt *opt);
 #endif
 static Opt *valid_args_find(CheckArg *, const char *lopt);
+static Opt *valid_args_find_n(CheckArg *, const char *lopt, size_t len);
 static Opt *valid_args_find_sopt(CheckArg *, char sopt);
+
+static void apply_env(CheckArg *);
+static Opt *env_opts_find(CheckArg *, const char *name, size_t len);
+static int prefix_opts_build(CheckArg *);
+static Opt *prefix_opts_find(CheckArg *, const char *name, size_t len);
 static void valid_args_free(Opt *vaptr);
 
 static void pos_args_append(CheckArg *, const char *);
@@ -59,6 +106,8 @@ static void pos_args_free(const char **);
 
 static int call_cb(CheckArg *, Opt *);
 
+static const char *scan_eq(const char *str);
+
 // fixme should return the number of converted chars,
 // and or error code
 static void string_toupper(char *);
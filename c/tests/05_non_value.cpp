@@ -6,11 +6,13 @@
 
 int cb_rc = 0;
 string cb_opt;
+const char *cb_val = nullptr;
 
 
 int
-callback(CheckArg *const, const char *o, const char *) {
+callback(CheckArg *const, const char *o, const char *v) {
   cb_opt = o;
+  cb_val = v;
   return cb_rc;
 }
 
@@ -48,6 +50,9 @@ TEST_CASE("options: long non-value options", "[non-val-opt]") {
 
   if (opt == "beta" || opt == "delta") {
     REQUIRE(cb_opt == opt);  // the callback ran!
+    REQUIRE(cb_val);
+    CHECK(string(cb_val).empty());  // with an empty value, like in C++
+    CHECK(string(checkarg_value(ca.get(), opt.c_str())).empty());
   }
   else {  //
     REQUIRE(cb_opt == "");
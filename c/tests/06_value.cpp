@@ -224,3 +224,31 @@ TEST_CASE("options: special values", "[opt-val]") {
 
   REQUIRE(value == checkarg_value(ca.get(), "input"));
 }
+
+TEST_CASE("options: long names and values", "[opt-val]") {
+  // certificates, JSON, ..., with names of every length around the scan block sizes
+  string blob = "{\"cert\": \"" + string(5000, 'Q') + "==\"}";
+
+  for (int len = 1; len < 70; ++len) {
+    string name(len, 'n'), flag = name + "-flag";
+    string with_value = "--" + name + "=" + blob;
+    string flag_only  = "--" + flag;
+    string flag_value = "--" + flag + "=" + blob;
+
+    CheckArgUPtr ca(checkarg_new("test06", NULL, NULL), &checkarg_free);
+    checkarg_add(ca.get(), 0, name.c_str(), "value option", CA_VT_REQUIRED, NULL);
+    checkarg_add(ca.get(), 0, flag.c_str(), "flag option", CA_VT_NONE, NULL);
+
+    INFO("name length: " << len);
+    vector<const char *> argv = {"/test06", with_value.c_str()};
+    REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_ALLOK);
+    CHECK(checkarg_value(ca.get(), name.c_str()) == blob);
+
+    argv[1] = flag_only.c_str();
+    REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_ALLOK);
+    CHECK(checkarg_isset(ca.get(), flag.c_str()));
+
+    argv[1] = flag_value.c_str();
+    REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_INVVAL);
+  }
+}
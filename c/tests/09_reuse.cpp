@@ -108,3 +108,48 @@ TEST_CASE("reuse", "[reuse]") {
   REQUIRE(checkarg_isset(ca.get(), "ng"));
   REQUIRE(string(checkarg_value(ca.get(), "ng")) == "ng-val");
 }
+
+TEST_CASE("reuse: flags and positional args", "[reuse]") {
+  const vector<const char *> argv1 = {"/test09", "-q", "--input=", "file1", "file2"};
+  const vector<const char *> argv2 = {"/test09", "file3"};
+
+  CheckArgUPtr ca(checkarg_new("test09", NULL, NULL), &checkarg_free);
+  checkarg_add(ca.get(), 'q', "quiet", "no output", CA_VT_NONE, NULL);
+  checkarg_add(ca.get(), 'i', "input", "file to read from", CA_VT_REQUIRED, NULL);
+
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(checkarg_parse(ca.get(), argv1.size(), (char **)argv1.data()) == CA_ALLOK);
+    CHECK(checkarg_isset(ca.get(), "quiet"));
+    CHECK(checkarg_isset(ca.get(), "input"));  // given, even if empty
+    CHECK(string(checkarg_value(ca.get(), "input")).empty());
+    REQUIRE(checkarg_pos_args_count(ca.get()) == 2);
+    CHECK(string(checkarg_pos_args(ca.get())[1]) == "file2");
+
+    REQUIRE(checkarg_parse(ca.get(), argv2.size(), (char **)argv2.data()) == CA_ALLOK);
+    CHECK(!checkarg_isset(ca.get(), "quiet"));
+    CHECK(!checkarg_isset(ca.get(), "input"));
+    REQUIRE(checkarg_pos_args_count(ca.get()) == 1);
+    CHECK(string(checkarg_pos_args(ca.get())[0]) == "file3");
+  }
+}
+
+TEST_CASE("reuse: values point into argv", "[reuse]") {
+  char callname[] = "/test09", input[] = "--input=file1", quiet[] = "-q";
+  char output[] = "-o", file[] = "file2";
+
+  char *argv[] = {callname, input, quiet, output, file, nullptr};
+
+  CheckArgUPtr ca(checkarg_new("test09", NULL, NULL), &checkarg_free);
+  checkarg_add(ca.get(), 'q', "quiet", "no output", CA_VT_NONE, NULL);
+  checkarg_add(ca.get(), 'i', "input", "file to read from", CA_VT_REQUIRED, NULL);
+  checkarg_add(ca.get(), 'o', "output", "file to write to", CA_VT_REQUIRED, NULL);
+
+  REQUIRE(checkarg_parse(ca.get(), 5, argv) == CA_ALLOK);
+  CHECK(checkarg_callname(ca.get()) == callname);
+  CHECK(checkarg_value(ca.get(), "input") == input + 8);
+  CHECK(checkarg_value(ca.get(), "output") == file);
+
+  // nothing is copied, so changes to argv show
+  file[4] = '3';
+  CHECK(string(checkarg_value(ca.get(), "output")) == "file3");
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+static int cb_calls = 0;
+
+int
+counting_callback(CheckArg *, const char *, const char *) {
+  ++cb_calls;
+  return 0;
+}
+
+// 50 options: every 5th has a callback, every other one takes a value
+static void
+add_options(CheckArg *ca) {
+  for (int i = 0; i < 50; ++i) {
+    string lopt = "option-" + std::to_string(i);
+    string help = "help of " + lopt;
+    char sopt   = i < 26 ? 'a' + i : 0;
+    uint8_t vt  = i % 2 ? CA_VT_REQUIRED : CA_VT_NONE;
+    if (i % 5 == 0)
+      checkarg_add_cb(ca, sopt, lopt.c_str(), counting_callback, help.c_str(), vt, "");
+    else
+      checkarg_add(ca, sopt, lopt.c_str(), help.c_str(), vt, "");
+  }
+}
+
+TEST_CASE("allocations: reparse of a warmed-up CheckArg", "[allocations]") {
+  const vector<const char *> argv = {
+    "/usr/local/bin/test10",
+    "--option-0",
+    "--option-1=a value",
+    "-d",
+    "value of d",
+    "-ceif",
+    "value of f",
+    "--option-13",
+    "value of option-13",
+    "positional-1",
+    "-g",
+    "positional-2",
+    "--option-49=last one",
+    "--",
+    "--positional-3",
+  };
+
+  CheckArgUPtr ca(checkarg_new("test10", NULL, NULL), &checkarg_free);
+  add_options(ca.get());
+
+  cb_calls = 0;
+  REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_ALLOK);
+  REQUIRE(checkarg_pos_args_count(ca.get()) == 3);
+  int calls_per_parse = cb_calls;
+
+  size_t allocs = alloc_count::count([&] {
+    REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_ALLOK);
+  });
+  CHECK(cb_calls == 2 * calls_per_parse);
+  CHECK(string(checkarg_value(ca.get(), "option-13")) == "value of option-13");
+
+  // values and positional args point into argv
+  CHECK(allocs == 0);
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+static void
+add_options(CheckArg *ca) {
+  checkarg_add(ca, 'a', "alpha", "alpha option", CA_VT_NONE, NULL);
+  checkarg_add(ca, 'b', "beta", "beta option", CA_VT_REQUIRED, NULL);
+  checkarg_add(ca, 'c', "gamma", "gamma option", CA_VT_REQUIRED, NULL);
+}
+
+static vector<string>
+collect(CheckArg *ca) {
+  vector<string> result;
+  CheckArgPosIter it = CHECKARG_POS_ITER_INIT;
+  const char *arg;
+  while ((arg = checkarg_pos_args_next(ca, &it))) result.emplace_back(arg);
+  return result;
+}
+
+TEST_CASE("lazy pos args: same as checkarg_pos_args()", "[lazy]") {
+  vector<const char *> argv = GENERATE(
+    vector<const char *>{"/test11"},
+    vector<const char *>{"/test11", "file1", "-a", "file2"},
+    vector<const char *>{"/test11", "-b", "file1", "--beta", "-a", "file2", ""},
+    vector<const char *>{"/test11", "-bvalue", "-ab", "-", "--beta=x", "file1"},
+    vector<const char *>{"/test11", "-ac", "--gamma", "file1", "--", "-a", "--beta"},
+    vector<const char *>{"/test11", "file1", "--unknown", "file2"},
+    vector<const char *>{"/test11", "file1", "-xa", "file2"},
+    vector<const char *>{"/test11", "file1", "--beta"});
+
+  CheckArgUPtr eager(checkarg_new("test11", NULL, NULL), &checkarg_free);
+  CheckArgUPtr lazy(checkarg_new("test11", NULL, NULL), &checkarg_free);
+  add_options(eager.get());
+  add_options(lazy.get());
+  checkarg_set_lazy_pos_args(lazy.get(), 1);
+
+  int rc = checkarg_parse(eager.get(), argv.size(), (char **)argv.data());
+  REQUIRE(checkarg_parse(lazy.get(), argv.size(), (char **)argv.data()) == rc);
+  CHECK(checkarg_pos_args_count(lazy.get()) == 0);
+
+  const char **pos_args = checkarg_pos_args(eager.get());
+  vector<string> expected(pos_args, pos_args + checkarg_pos_args_count(eager.get()));
+  CHECK(collect(lazy.get()) == expected);
+  CHECK(collect(eager.get()) == expected);
+}
+
+TEST_CASE("lazy pos args: no allocations", "[lazy][allocations]") {
+  vector<string> files;
+  for (int i = 0; i < 1000; ++i) files.push_back("some/long/path/to/file-" + std::to_string(i));
+  vector<const char *> argv = {"/test11", "--alpha"};
+  for (auto &file : files) argv.push_back(file.c_str());
+
+  CheckArgUPtr ca(checkarg_new("test11", NULL, NULL), &checkarg_free);
+  add_options(ca.get());
+  checkarg_set_lazy_pos_args(ca.get(), 1);
+
+  size_t count = 0;
+  CHECK(alloc_count::count([&] {
+          REQUIRE(checkarg_parse(ca.get(), argv.size(), (char **)argv.data()) == CA_ALLOK);
+          CheckArgPosIter it = CHECKARG_POS_ITER_INIT;
+          while (checkarg_pos_args_next(ca.get(), &it)) ++count;
+        }) == 0);
+  CHECK(count == 1000);
+
+  // nothing left after a reset
+  checkarg_reset(ca.get());
+  CHECK(collect(ca.get()).empty());
+}
@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+#include "test.hpp"
+
+
+// runs checkarg_parse_consume() on args, returns what is left in argv,
+// values point into args, so the caller keeps them for as long as it checks those
+static vector<string>
+consume(CheckArg *ca, vector<string> &args, int expected_rc = CA_ALLOK) {
+  vector<char *> argv;
+  for (auto &arg : args) argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  int argc = args.size();
+  REQUIRE(checkarg_parse_consume(ca, &argc, argv.data()) == expected_rc);
+  REQUIRE(argv[argc] == nullptr);
+  return vector<string>(argv.begin(), argv.begin() + argc);
+}
+
+TEST_CASE("consume: known options are removed", "[consume]") {
+  CheckArgUPtr ca(checkarg_new("test12", NULL, NULL), &checkarg_free);
+  checkarg_add(ca.get(), 'v', "verbose", "be verbose", CA_VT_NONE, NULL);
+  checkarg_add(ca.get(), 'o', "output", "output file", CA_VT_REQUIRED, NULL);
+
+  SECTION("only known options") {
+    vector<string> args = {"/test12", "-v", "--output", "out"};
+    CHECK(consume(ca.get(), args) == vector<string>{"/test12"});
+    CHECK(checkarg_isset(ca.get(), "verbose"));
+    CHECK(string(checkarg_value(ca.get(), "output")) == "out");
+  }
+
+  SECTION("unknown options and positional args pass through in order") {
+    vector<string> args = {"/test12", "--gtk-debug=all", "-v", "file1", "-x", "-oout",
+                           "--unknown", "value", "-vo", "out2", "file2"};
+    auto left           = consume(ca.get(), args);
+    CHECK(
+      left
+      == vector<string>{"/test12", "--gtk-debug=all", "file1", "-x", "--unknown", "value",
+                        "file2"});
+    CHECK(string(checkarg_value(ca.get(), "output")) == "out2");
+    CHECK(checkarg_pos_args_count(ca.get()) == 3);
+  }
+
+  SECTION("everything after a separator is kept") {
+    vector<string> args = {"/test12", "-v", "--", "-v", "--output", "x"};
+    auto left           = consume(ca.get(), args);
+    CHECK(left == vector<string>{"/test12", "--", "-v", "--output", "x"});
+  }
+
+  SECTION("errors leave the rest") {
+    vector<string> args = {"/test12", "-v", "a", "--verbose=x", "b"};
+    auto left           = consume(ca.get(), args, CA_INVVAL);
+    CHECK(left == vector<string>{"/test12", "a", "--verbose=x", "b"});
+
+    vector<string> args2 = {"/test12", "-v", "--output"};
+    left                 = consume(ca.get(), args2, CA_MISSVAL);
+    CHECK(left == vector<string>{"/test12"});
+  }
+
+  SECTION("positional args are collected, even if lazy") {
+    checkarg_set_lazy_pos_args(ca.get(), 1);
+    vector<string> args = {"/test12", "-v", "a", "-x", "b", "--", "-v"};
+    auto left           = consume(ca.get(), args);
+    CHECK(left == vector<string>{"/test12", "a", "-x", "b", "--", "-v"});
+    REQUIRE(checkarg_pos_args_count(ca.get()) == 3);
+    CHECK(string(checkarg_pos_args(ca.get())[2]) == "-v");
+
+    vector<string> iterated;
+    CheckArgPosIter it = CHECKARG_POS_ITER_INIT;
+    while (auto arg = checkarg_pos_args_next(ca.get(), &it)) iterated.emplace_back(arg);
+    CHECK(iterated == vector<string>{"a", "b", "-v"});
+  }
+}
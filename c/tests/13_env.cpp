@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+#include <cstdlib>
+
+
+static int
+parse(CheckArg *ca, const vector<const char *> &argv) {
+  return checkarg_parse(ca, argv.size(), const_cast<char **>(argv.data()));
+}
+
+TEST_CASE("env: bound and prefixed variables", "[env]") {
+  setenv("TEST13_THREADS", "8", 1);
+  setenv("TEST13_VERBOSE", "1", 1);
+  setenv("TEST13_QUIET", "0", 1);
+  setenv("TEST13P_OUTPUT_FORMAT", "json", 1);
+  setenv("TEST13P_LEVEL", "prefixed", 1);
+  setenv("TEST13_LEVEL", "bound", 1);
+
+  CheckArgUPtr ca(checkarg_new("test13", NULL, NULL), &checkarg_free);
+  checkarg_add(ca.get(), 't', "threads", "number of threads", CA_VT_REQUIRED, NULL);
+  checkarg_add(ca.get(), 'v', "verbose", "be verbose", CA_VT_NONE, NULL);
+  checkarg_add(ca.get(), 'q', "quiet", "be quiet", CA_VT_NONE, NULL);
+  checkarg_add_long(ca.get(), "output-format", "format", CA_VT_REQUIRED, NULL);
+  checkarg_add_long(ca.get(), "level", "some level", CA_VT_REQUIRED, NULL);
+
+  REQUIRE(checkarg_bind_env(ca.get(), "threads", "TEST13_THREADS") == CA_ALLOK);
+  REQUIRE(checkarg_bind_env(ca.get(), "verbose", "TEST13_VERBOSE") == CA_ALLOK);
+  REQUIRE(checkarg_bind_env(ca.get(), "quiet", "TEST13_QUIET") == CA_ALLOK);
+  CHECK(checkarg_bind_env(ca.get(), "unknown", "TEST13_X") == CA_INVOPT);
+
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(checkarg_isset(ca.get(), "threads"));
+  CHECK(checkarg_value(ca.get(), "threads") == getenv("TEST13_THREADS"));
+  CHECK(checkarg_isset(ca.get(), "verbose"));
+  CHECK(!checkarg_isset(ca.get(), "quiet"));
+  CHECK(!checkarg_isset(ca.get(), "output-format"));
+
+  // the command line wins
+  REQUIRE(parse(ca.get(), {"/test13", "-t2"}) == CA_ALLOK);
+  CHECK(string(checkarg_value(ca.get(), "threads")) == "2");
+
+  REQUIRE(checkarg_set_env_prefix(ca.get(), "TEST13P_") == CA_ALLOK);
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(string(checkarg_value(ca.get(), "output-format")) == "json");
+  CHECK(string(checkarg_value(ca.get(), "level")) == "prefixed");
+
+  // options added later are found, too
+  setenv("TEST13P_LATE_OPTION", "late", 1);
+  checkarg_add_long(ca.get(), "late-option", "added late", CA_VT_REQUIRED, NULL);
+  checkarg_add_long(ca.get(), "late", "a prefix of it", CA_VT_REQUIRED, NULL);
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(string(checkarg_value(ca.get(), "late-option")) == "late");
+  CHECK(!checkarg_isset(ca.get(), "late"));
+
+  // the variable's case doesn't matter, the long option's does, like in C++
+  setenv("TEST13P_Mixed_CASE", "mixed", 1);
+  setenv("TEST13P_UPPER", "upper", 1);
+  checkarg_add_long(ca.get(), "mixed-case", "in the variable", CA_VT_REQUIRED, NULL);
+  checkarg_add_long(ca.get(), "Upper", "in the option", CA_VT_REQUIRED, NULL);
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(string(checkarg_value(ca.get(), "mixed-case")) == "mixed");
+  CHECK(!checkarg_isset(ca.get(), "Upper"));
+
+  // a bound variable wins, a variable is bound to one option only
+  REQUIRE(checkarg_bind_env(ca.get(), "level", "TEST13_LEVEL") == CA_ALLOK);
+  REQUIRE(checkarg_bind_env(ca.get(), "level", "TEST13_THREADS") == CA_ALLOK);
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(string(checkarg_value(ca.get(), "level")) == "8");
+  CHECK(!checkarg_isset(ca.get(), "threads"));
+
+  // a warmed-up parse doesn't allocate
+  vector<const char *> argv = {"/test13", "-v"};
+  CHECK(alloc_count::count([&] { REQUIRE(parse(ca.get(), argv) == CA_ALLOK); }) == 0);
+
+  REQUIRE(checkarg_set_env_prefix(ca.get(), NULL) == CA_ALLOK);
+  REQUIRE(parse(ca.get(), {"/test13"}) == CA_ALLOK);
+  CHECK(!checkarg_isset(ca.get(), "output-format"));
+}
@@ -4,12 +4,16 @@
 #include "checkargpp.hpp"
 #include "checkargpp_private.hpp"
 
-#if CA_PRINTERR
-#include <cstdarg>
-#endif
-
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <random>
 #include <sstream>
+#include <thread>
 // #include <format>
 
 #ifdef HAS_STD_FILESYSTEM
@@ -17,6 +21,22 @@
 namespace fs = std::filesystem;
 #endif
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef HAS_SYS_MMAN
+#include <sys/mman.h>
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define CA_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+// POSIX wants this to be declared by whoever uses it
+extern char **environ;
+
 using std::map;
 
 using std::cout;
@@ -29,6 +49,8 @@ using std::stringstream;
 using std::vector;
 
 using checkarg::CheckArgPrivate;
+using checkarg::find_char;
+using checkarg::no_slot;
 using checkarg::str_to_upper;
 
 /**
@@ -97,12 +119,17 @@ using checkarg::str_to_upper;
  */
 
 map<int, string> CheckArgPrivate::errors = {
-  {CA_ALLOK,    "Everything is fine"               },
-  {CA_ERROR,    "An Error occurred"                },
-  {CA_INVOPT,   "Unknown command line option"      },
-  {CA_INVVAL,   "Value given to non-value option"  },
-  {CA_MISSVAL,  "Missing value of option"          },
-  {CA_CALLBACK, "Callback returned with error code"},
+  {CA_ALLOK,      "Everything is fine"               },
+  {CA_ERROR,      "An Error occurred"                },
+  {CA_INVOPT,     "Unknown command line option"      },
+  {CA_INVVAL,     "Value given to non-value option"  },
+  {CA_MISSVAL,    "Missing value of option"          },
+  {CA_CALLBACK,   "Callback returned with error code"},
+  {CA_BADVAL,     "Invalid value for a bound flag"   },
+  {CA_LIMIT,      "Parse limit exceeded"             },
+  {CA_INVFEATURE, "Unknown feature"                  },
+  {CA_CONSTRAINT, "Option constraint violated"       },
+  {CA_PATH,       "Invalid path argument"            },
 };
 
 // c'tors
@@ -166,6 +193,15 @@ CheckArgPrivate::CheckArgPrivate(
   if (!appname.empty()) usage_line = appname + " [options]";
 }
 
+CheckArgPrivate::~CheckArgPrivate() {
+#ifdef HAS_SYS_MMAN
+  for (auto &[path, contents] : files.entries()) {
+    if (contents.empty()) continue;
+    ::munmap(const_cast<char *>(contents.data()), contents.size());
+  }
+#endif
+}
+
 /**
  * \brief set help's text for positional arguments
  * \param usage text to be appended to the usage line, like " [files...]"
@@ -225,37 +261,218 @@ CheckArg::pos_args() const {
   return p->pos_args;
 }
 
+/**
+ * \brief iterate over the positional args of the last parse
+ *
+ * Yields the same args pos_args() would, whether or not
+ * set_lazy_pos_args() was used.
+ * If it was, and parse() was given argc/argv or a vector, the positional args
+ * are found while iterating, by skipping the options and their values
+ * in that argv, so it must still be valid.
+ * Otherwise it iterates over the collected pos_args().
+ * \return an input range of std::string_view
+ */
+CheckArg::PosArgRange
+CheckArg::pos_args_range() const {
+  return PosArgRange(this);
+}
+
+CheckArg::PosArgRange::iterator
+CheckArg::PosArgRange::begin() const {
+  iterator it;
+  it.ca = ca;
+  if (ca->p->cleared) return it;  // nothing parsed since the last reset()
+
+  if (!ca->p->argv_kept()) {
+    // not lazy, or argv could not be iterated again, so they were collected
+    it.end = ca->p->pos_args.size();
+    return it;
+  }
+
+  // positional args after an error were not parsed
+  it.end   = ca->p->parsed_argc;
+  it.index = ca->next_pos_arg(1, it.end, it.sep);
+  return it;
+}
+
+std::string_view
+CheckArg::argv_at(int index) const {
+  if (p->argv_ptrs) return p->argv_ptrs[index];
+  if (p->argv_strs) return p->argv_strs[index];
+  return p->pos_args[index];
+}
+
+int
+CheckArg::next_pos_arg(int index, int end, bool &sep) const {
+  using Priv = checkarg::CheckArgPrivate;
+  if (!p->argv_kept()) return index;  // iterating pos_args
+  for (; index < end; ++index) {
+    if (sep) return index;
+    auto kind = p->classify(argv_at(index));
+    if (kind == Priv::AK_POSITIONAL) return index;
+    if (kind & Priv::AK_SEPARATOR) sep = true;
+    if (kind & Priv::AK_CONSUMES) ++index;  // skip the value
+  }
+  return end;
+}
+
 
 /**
- * \brief get error message for given errno
- * \param errno error number
+ * \brief get error message for given error code
+ * \param eno error number
  * \return error message string
  * \see CAError
  */
 string
-CheckArg::str_err(const int errno) {
-  return CheckArgPrivate::errors[errno];
+CheckArg::str_err(const int eno) {
+  return CheckArgPrivate::errors[eno];
 }
 
-int
-CheckArgPrivate::ca_error(int eno, const char *info, ...) const {
-#if CA_PRINTERR
-  va_list al;
-  va_start(al, info);
-  char *buff;
-  int i = vasprintf(&buff, info, al);
-  if (i > -1) {
-    std::cerr << "Error: " << errors[eno] << buff << endl;
-    free(buff);
+/**
+ * \brief get details about the error the last parse() returned
+ * \warning ParseError::option points into the argv given to parse()
+ * \return the error, its code is CA_ALLOK if there was none
+ */
+const checkarg::ParseError &
+CheckArg::error() const {
+  return p->error;
+}
+
+/**
+ * \brief get the message for the error the last parse() returned
+ * \return the message, as it would have been printed on stderr
+ * \see set_print_errors()
+ */
+string
+CheckArg::error_message() const {
+  return checkarg::format_error(p->error);
+}
+
+/**
+ * \brief print errors to stderr while parsing
+ *
+ * The default is set by the printerr build option.
+ * Turn it off, if errors shall be handled using error() or error_message().
+ * \param print whether to print errors
+ */
+void
+CheckArg::set_print_errors(bool print) {
+  p->print_errors = print;
+}
+
+string
+checkarg::format_error(const ParseError &err) {
+  stringstream ss;
+  ss << CheckArg::str_err(err.code);
+  if (err.code == CA_CALLBACK) { ss << ": " << err.cb_code << "!"; }
+  else if (err.code == CA_CONSTRAINT) {
+    ss << ": " << err.detail << "!";
   }
-  va_end(al);
-#endif
-  return eno;
+  else if (err.code == CA_PATH) {
+    ss << ": " << err.option << " (" << err.detail << ")!";
+  }
+  else if (err.code == CA_INVFEATURE) {
+    ss << ": " << err.option << "!";
+  }
+  else if (!err.option.empty()) {
+    ss << (err.is_short ? ": -" : ": --") << err.option << "!";
+  }
+  else if (err.detail) {
+    ss << ": " << err.detail << "!";
+  }
+  if (!err.suggestion.empty()) ss << " Did you mean --" << err.suggestion << "?";
+  return ss.str();
+}
+
+int
+CheckArgPrivate::ca_error(int eno, const char *detail) {
+  return ca_error({.code = eno, .detail = detail});
+}
+
+int
+CheckArgPrivate::ca_error(const ParseError &err) {
+  CA_PROBE(error, err.code, err.index);
+  error = err;
+  if (print_errors) std::cerr << "Error: " << format_error(error) << endl;
+  return error.code;
 }
 
 // bigger functions
 //
 
+uint32_t
+CheckArgPrivate::add_opt(
+  char sopt, std::string_view lopt, std::string_view help, Callback cb,
+  CAValueType value_type, std::string_view value_name) {
+  uint32_t slot = opts.size();
+  opts.push_back({.value_type = value_type, .sopt = sopt, .has_cb = bool(cb)});
+  opt_help.push_back({.help = help, .value_name = value_name});
+  defaults.emplace_back();
+  values.emplace_back();
+  callbacks.emplace_back();
+  if (cb) callbacks.back() = {.fn = std::move(cb), .name = string(lopt)};
+  names.push_back(lopt);
+
+  // sorted lazily by find(), adding an option twice replaces the first one there
+  valid_args.emplace_back(lopt, slot);
+  valid_args_sorted = false;
+  suggest_tree.clear();
+
+  if (sopt) short2slot[(unsigned char)sopt] = slot;
+  if (value_type == CA_VT_DICT) dicts.emplace_back(slot, FlatMap{});
+  if (value_type == CA_VT_LIST) lists.emplace_back(slot, vector<std::string_view>{});
+  return slot;
+}
+
+void
+CheckArgPrivate::reserve(size_t n) {
+  opts.reserve(n);
+  opt_help.reserve(n);
+  defaults.reserve(n);
+  values.reserve(n);
+  callbacks.reserve(n);
+  names.reserve(n);
+  valid_args.reserve(n);
+}
+
+std::string_view
+CheckArgPrivate::keep(string str) {
+  if (str.empty()) return {};
+  return strings.emplace_back(std::move(str));
+}
+
+uint32_t
+CheckArgPrivate::find(std::string_view lopt) const {
+  if (!valid_args_sorted) sort_valid_args();
+  auto pos = std::lower_bound(
+    valid_args.begin(), valid_args.end(), lopt,
+    [](const auto &entry, std::string_view name) { return entry.first < name; });
+  if (pos != valid_args.end() && pos->first == lopt) return pos->second;
+  return no_slot;
+}
+
+void
+CheckArgPrivate::sort_valid_args() const {
+  // sorting by name and slot keeps options added more than once in order
+  std::sort(valid_args.begin(), valid_args.end());
+
+  // of options added more than once only the last one stays,
+  // its short option takes over the ones of the replaced ones
+  auto out = valid_args.begin();
+  for (auto it = valid_args.begin(); it != valid_args.end(); ++it) {
+    if (out != valid_args.begin() && (out - 1)->first == it->first) {
+      auto replaced = (out - 1)->second;
+      for (auto &slot : short2slot)
+        if (slot == replaced) slot = it->second;
+      *(out - 1) = *it;
+    }
+    else {
+      *out++ = *it;
+    }
+  }
+  valid_args.erase(out, valid_args.end());
+  valid_args_sorted = true;
+}
 
 /**
  * \brief add a command line option the parser shall accept
@@ -270,12 +487,7 @@ int
 CheckArg::add(
   const char sopt, const string &lopt, const string &help,
   const CAValueType value_type) {
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .sopt       = sopt,
-    .help       = help,
-  };
-  p->short2long[sopt] = lopt;
+  p->add_opt(sopt, p->keep(lopt), p->keep(help), nullptr, value_type, {});
   return CA_ALLOK;
 }
 
@@ -292,16 +504,9 @@ int
 CheckArg::add(
   const char sopt, const string &lopt, const string &help, const CAValueType value_type,
   const string &value_name) {
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .sopt       = sopt,
-    .help       = help,
-  };
-  if (value_name.empty()) { p->valid_args[lopt].value_name = str_to_upper(lopt); }
-  else {
-    p->valid_args[lopt].value_name = value_name;
-  }
-  p->short2long[sopt] = lopt;
+  p->add_opt(
+    sopt, p->keep(lopt), p->keep(help), nullptr, value_type,
+    p->keep(value_name.empty() ? str_to_upper(lopt) : value_name));
   return CA_ALLOK;
 }
 /**
@@ -319,13 +524,7 @@ CheckArg::add(
   const char sopt, const string &lopt, const string &help,
   std::function<int(CheckArg *const, const string &, const string &)> cb,
   const CAValueType value_type) {
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .sopt       = sopt,
-    .cb         = cb,
-    .help       = help,
-  };
-  p->short2long[sopt] = lopt;
+  p->add_opt(sopt, p->keep(lopt), p->keep(help), cb, value_type, {});
   return CA_ALLOK;
 }
 
@@ -344,18 +543,9 @@ CheckArg::add(
   const char sopt, const string &lopt, const string &help,
   std::function<int(CheckArg *const, const string &, const string &)> cb,
   const CAValueType value_type, const string &value_name) {
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .sopt       = sopt,
-    .cb         = cb,
-    .help       = help,
-  };
-
-  if (value_name.empty()) { p->valid_args[lopt].value_name = str_to_upper(lopt); }
-  else {
-    p->valid_args[lopt].value_name = value_name;
-  }
-  p->short2long[sopt] = lopt;
+  p->add_opt(
+    sopt, p->keep(lopt), p->keep(help), cb, value_type,
+    p->keep(value_name.empty() ? str_to_upper(lopt) : value_name));
   return CA_ALLOK;
 }
 
@@ -369,8 +559,7 @@ CheckArg::add(
  */
 int
 CheckArg::add(const string &lopt, const string &help, const CAValueType value_type) {
-  p->valid_args[lopt] = {.value_type = value_type, .help = help};
-
+  p->add_opt(0, p->keep(lopt), p->keep(help), nullptr, value_type, {});
   return CA_ALLOK;
 }
 
@@ -386,17 +575,9 @@ int
 CheckArg::add(
   const string &lopt, const string &help, const CAValueType value_type,
   const string &value_name) {
-
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .help       = help,
-  };
-
-  if (value_name.empty()) { p->valid_args[lopt].value_name = str_to_upper(lopt); }
-  else {
-    p->valid_args[lopt].value_name = value_name;
-  }
-
+  p->add_opt(
+    0, p->keep(lopt), p->keep(help), nullptr, value_type,
+    p->keep(value_name.empty() ? str_to_upper(lopt) : value_name));
   return CA_ALLOK;
 }
 
@@ -414,8 +595,7 @@ CheckArg::add(
   const string &lopt, const string &help,
   std::function<int(CheckArg *const, const string &, const string &)> cb,
   const CAValueType value_type) {
-  p->valid_args[lopt] = {.value_type = value_type, .cb = cb, .help = help};
-
+  p->add_opt(0, p->keep(lopt), p->keep(help), cb, value_type, {});
   return CA_ALLOK;
 }
 
@@ -433,19 +613,389 @@ CheckArg::add(
   const string &lopt, const string &help,
   std::function<int(CheckArg *const, const string &, const string &)> cb,
   const CAValueType value_type, const string &value_name) {
-  p->valid_args[lopt] = {
-    .value_type = value_type,
-    .cb         = cb,
-    .help       = help,
-  };
+  p->add_opt(
+    0, p->keep(lopt), p->keep(help), cb, value_type,
+    p->keep(value_name.empty() ? str_to_upper(lopt) : value_name));
+  return CA_ALLOK;
+}
+
+
+/**
+ * \brief add many command line options the parser shall accept at once
+ *
+ * Unlike add(), this does not copy the strings of the specs, they're borrowed
+ * and must stay valid as long as this CheckArg is used.
+ * The option tables are sized once for all of the specs and value names
+ * generated for value options without one share a single allocation.
+ * \param specs the options to add, usually a constexpr array
+ * \return a return code from CAError
+ * \see CAError
+ */
+int
+CheckArg::add_all(std::span<const checkarg::OptSpec> specs) {
+  p->reserve(p->opts.size() + specs.size());
+
+  size_t generated = 0;
+  for (auto &spec : specs) {
+    if (spec.value_type != CA_VT_NONE && spec.value_name.empty())
+      generated += spec.lopt.size();
+  }
+  char *block = nullptr;
+  if (generated) block = p->blocks.emplace_back(new char[generated]).get();
+
+  for (auto &spec : specs) {
+    auto value_name = spec.value_name;
+    if (spec.value_type != CA_VT_NONE && value_name.empty()) {
+      str_to_upper(spec.lopt, block);
+      value_name = {block, spec.lopt.size()};
+      block += spec.lopt.size();
+    }
+    auto slot = p->add_opt(
+      spec.sopt, spec.lopt, spec.help, spec.cb ? checkarg::Callback(spec.cb) : nullptr,
+      spec.value_type, value_name);
+    p->opts[slot].delimiter = spec.delimiter;
+    if (checkarg::single_value(spec.value_type)) p->defaults[slot] = spec.default_value;
+  }
+  return CA_ALLOK;
+}
+
+/**
+ * \brief require an option to be given
+ *
+ * A parse without it fails with CA_CONSTRAINT, error().rule tells which
+ * constraint failed, in the order all of them were added.
+ * \param lopt the long name of the option
+ * \return CA_ALLOK, CA_INVOPT if there is no such option
+ */
+int
+CheckArg::add_required(const string &lopt) {
+  return p->add_constraint(
+    CheckArgPrivate::CK_REQUIRED, {lopt}, "--" + lopt + " is required");
+}
+
+/**
+ * \brief allow at most one of some options to be given
+ * \param lopts the long names of the options
+ * \return CA_ALLOK, CA_INVOPT if one of them doesn't exist,
+ *         CA_ERROR if there are less than two
+ * \see add_required()
+ */
+int
+CheckArg::add_conflict(const vector<string> &lopts) {
+  if (lopts.size() < 2) return CA_ERROR;
+  string rule = "only one of";
+  for (auto &lopt : lopts) rule += (&lopt == &lopts[0] ? " --" : ", --") + lopt;
+  rule += " may be given";
+  return p->add_constraint(CheckArgPrivate::CK_CONFLICT, lopts, std::move(rule));
+}
+
+/**
+ * \brief require an option to be given if another one is
+ * \param lopt the long name of the option requiring the other one
+ * \param required the long name of the required option
+ * \return CA_ALLOK, CA_INVOPT if one of them doesn't exist
+ * \see add_required()
+ */
+int
+CheckArg::add_requires(const string &lopt, const string &required) {
+  return p->add_constraint(
+    CheckArgPrivate::CK_REQUIRES, {lopt, required},
+    "--" + lopt + " requires --" + required);
+}
+
+int
+CheckArgPrivate::add_constraint(
+  ConstraintKind kind, const vector<string> &lopts, string rule) {
+  vector<uint32_t> slots;
+  for (auto &lopt : lopts) {
+    auto slot = find(lopt);
+    if (slot == no_slot) return CA_INVOPT;
+    slots.push_back(slot);
+  }
+  constraints.push_back({.kind = kind, .slots = std::move(slots), .rule = keep(rule)});
+  constraints_compiled = false;
+  return CA_ALLOK;
+}
+
+void
+CheckArgPrivate::compile_constraints() {
+  // a bit for each option in any constraint
+  constrained.clear();
+  for (auto &constraint : constraints)
+    for (auto slot : constraint.slots) constrained.push_back(slot);
+  std::sort(constrained.begin(), constrained.end());
+  auto last = std::unique(constrained.begin(), constrained.end());
+  constrained.erase(last, constrained.end());
+
+  size_t words = (constrained.size() + 63) / 64;
+  presence.assign(words, 0);
+  constraint_masks.assign(2 * words * constraints.size(), 0);
+  for (size_t i = 0; i < constraints.size(); ++i) {
+    auto &slots = constraints[i].slots;
+    for (size_t k = 0; k < slots.size(); ++k) {
+      size_t bit = std::lower_bound(constrained.begin(), constrained.end(), slots[k])
+                   - constrained.begin();
+      // the first mask is all of them, but the required one of CK_REQUIRES
+      bool second = constraints[i].kind == CK_REQUIRES && k == 1;
+      auto &word  = constraint_masks[(2 * i + second) * words + bit / 64];
+      word |= uint64_t(1) << (bit % 64);
+    }
+  }
+  constraints_compiled = true;
+}
+
+int
+CheckArgPrivate::check_constraints() {
+  if (constraints.empty()) return CA_ALLOK;
+  if (!constraints_compiled) compile_constraints();
+
+  size_t words = presence.size();
+  std::fill(presence.begin(), presence.end(), 0);
+  for (size_t bit = 0; bit < constrained.size(); ++bit)
+    if (is_seen(constrained[bit])) presence[bit / 64] |= uint64_t(1) << (bit % 64);
+
+  for (size_t i = 0; i < constraints.size(); ++i) {
+    const uint64_t *mask  = &constraint_masks[2 * i * words];
+    const uint64_t *other = mask + words;
+    auto kind             = constraints[i].kind;
+
+    bool missing = false;  // whether the required one of CK_REQUIRES is
+    if (kind == CK_REQUIRES)
+      for (size_t w = 0; w < words; ++w) missing |= (other[w] & ~presence[w]) != 0;
+
+    uint32_t blame = no_slot;  // the bit of the option to blame
+    size_t given   = 0;
+    for (size_t w = 0; w < words && blame == no_slot; ++w) {
+      uint64_t bits = 0;
+      switch (kind) {
+      case CK_REQUIRED:  // missing ones
+        bits = mask[w] & ~presence[w];
+        break;
+      case CK_CONFLICT:  // all but the first one given
+        bits = mask[w] & presence[w];
+        given += std::popcount(bits);
+        if (given < 2) bits = 0;
+        else if (given == size_t(std::popcount(bits))) bits &= bits - 1;
+        break;
+      case CK_REQUIRES:  // the requiring one
+        if (missing) bits = mask[w] & presence[w];
+        break;
+      }
+      if (bits) blame = w * 64 + std::countr_zero(bits);
+    }
+
+    if (blame != no_slot) {
+      return ca_error({
+        .code   = CA_CONSTRAINT,
+        .offset = 2,
+        .option = names[constrained[blame]],
+        .detail = constraints[i].rule.data(),
+        .rule   = int(i),
+      });
+    }
+  }
+  return CA_ALLOK;
+}
 
-  if (value_name.empty()) { p->valid_args[lopt].value_name = str_to_upper(lopt); }
+/**
+ * \brief take the value of an option from an environment variable
+ *
+ * After parsing, options not given on the command line get the value
+ * of their variable, if it is set. Non-value options are set by any value
+ * but an empty one and "0". Their callbacks are not called.
+ * All variables are found in a single pass over the environment.
+ * \param lopt the long name of the option
+ * \param var the name of the environment variable, like APP_THREADS
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL for CA_VT_DICT and CA_VT_LIST options
+ * \see set_env_prefix()
+ */
+int
+CheckArg::bind_env(const string &lopt, const string &var) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  auto value_type = p->opts[slot].value_type;
+  if (value_type && !checkarg::single_value(value_type)) return CA_INVVAL;
+
+  if (auto bind = p->env_binds.find(var)) {
+    p->env_bind_slots[bind - p->env_binds.entries().data()] = slot;
+  }
   else {
-    p->valid_args[lopt].value_name = value_name;
+    p->env_binds.set(p->keep(var), {});
+    p->env_bind_slots.push_back(slot);
+  }
+  return CA_ALLOK;
+}
+
+/**
+ * \brief take values of all options from environment variables with a prefix
+ *
+ * Like bind_env() for every option, the variable of `--output-format`
+ * being `<prefix>OUTPUT_FORMAT`. Variables bound by bind_env() take precedence.
+ * The rest of a variable's name is lower-cased and '_' taken as '-', so
+ * `<prefix>Output_Format` works too, but options with upper-case letters
+ * in their long name have to be bound by bind_env().
+ * \param prefix like "APP_", empty to disable this
+ */
+void
+CheckArg::set_env_prefix(const string &prefix) {
+  p->env_prefix = prefix;
+}
+
+/**
+ * \brief set the value an option has, if it is not given
+ *
+ * The default is kept once with the options,
+ * value() and value_view() fall back to it, isset() does not.
+ * \param lopt the long name of the option
+ * \param value the default value
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL if it does not take a single value
+ */
+int
+CheckArg::set_default(const string &lopt, const string &value) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  if (!checkarg::single_value(p->opts[slot].value_type)) return CA_INVVAL;
+  p->defaults[slot] = p->keep(value);
+  return CA_ALLOK;
+}
+
+/**
+ * \brief set where the values of a CA_VT_LIST option are split
+ * \param lopt the long name of the option
+ * \param delimiter the character between the items, ',' by default
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL if it is no CA_VT_LIST option
+ */
+int
+CheckArg::set_delimiter(const string &lopt, char delimiter) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  if (p->opts[slot].value_type != CA_VT_LIST) return CA_INVVAL;
+  p->opts[slot].delimiter = delimiter;
+  return CA_ALLOK;
+}
+
+/**
+ * \brief check that the value of an option is a path
+ *
+ * After a successful parse, the value is checked to exist and, depending on
+ * checks, to be a file or a directory and readable, otherwise the parse fails
+ * with CA_PATH. Values from defaults and the environment are checked, too.
+ * \param lopt the long name of the option
+ * \param checks the checkarg::PathCheck bits, 0 to not check it
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL if it does not take a single value
+ * \see set_pos_path_check(), path_errors()
+ */
+int
+CheckArg::set_path_check(const string &lopt, unsigned checks) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  if (!checkarg::single_value(p->opts[slot].value_type)) return CA_INVVAL;
+  std::erase_if(p->path_opts, [slot](auto &opt) { return opt.slot == slot; });
+  if (checks) p->path_opts.push_back({.slot = slot, .checks = uint8_t(checks)});
+  return CA_ALLOK;
+}
+
+/**
+ * \brief check that all positional args are paths
+ *
+ * Like set_path_check() for every positional arg.
+ * Large numbers of paths are checked in parallel, see set_parse_threads().
+ * \param checks the checkarg::PathCheck bits, 0 to not check them
+ */
+void
+CheckArg::set_pos_path_check(unsigned checks) {
+  p->pos_path_checks = checks;
+}
+
+/**
+ * \brief get every path failing its checks in the last parse
+ *
+ * Unlike error(), this has all of them, to report every missing file at once.
+ * Each has the argv index of the path, -1 if it is a default or from
+ * the environment, the path as `option` and why it failed as `detail`.
+ * \return the errors in argv order, empty if the parse did not get to the checks
+ */
+std::span<const checkarg::ParseError>
+CheckArg::path_errors() const {
+  return p->path_errors;
+}
+
+/**
+ * \brief register a named feature
+ *
+ * Features get dense indices in the order they are first added,
+ * the returned handle tests the feature's bit without any lookup.
+ * Adding a feature again returns the same handle, with the new default.
+ * \param name the name of the feature, as given in the feature options
+ * \param enabled whether the feature is enabled if no feature option says otherwise
+ * \return a handle to check the feature with
+ * \see add_feature_options()
+ */
+checkarg::FeatureHandle
+CheckArg::add_feature(const string &name, bool enabled) {
+  auto entry = p->features.find(name);
+  if (!entry) {
+    p->features.set(p->keep(name), {});
+    entry = &p->features.entries().back();
+  }
+  uint32_t index = entry - p->features.entries().data();
+
+  size_t words = index / 64 + 1;
+  if (p->feature_defaults.size() < words) {
+    p->feature_defaults.resize(words);
+    p->feature_scratch.resize(words);
+    while (p->feature_bits.size() < words) p->feature_bits.emplace_back(0);
+  }
+  uint64_t bit = uint64_t(1) << (index % 64);
+  auto &word   = p->feature_bits[index / 64];
+  if (enabled) {
+    p->feature_defaults[index / 64] |= bit;
+    word.fetch_or(bit, std::memory_order_relaxed);
+  } else {
+    p->feature_defaults[index / 64] &= ~bit;
+    word.fetch_and(~bit, std::memory_order_relaxed);
   }
+  return {&word, index};
+}
+
+/**
+ * \brief add the options enabling and disabling features
+ *
+ * Both take comma separated lists of feature names and may be given
+ * more than once, a feature both enabled and disabled is disabled.
+ * Unknown feature names fail the parse with CA_INVFEATURE.
+ * \param enable_lopt the long name of the option enabling features
+ * \param disable_lopt the long name of the option disabling features
+ * \return CA_ALLOK
+ * \see add_feature()
+ */
+int
+CheckArg::add_feature_options(const string &enable_lopt, const string &disable_lopt) {
+  auto features = p->keep("FEATURES");
+  p->enable_slot = p->add_opt(
+    0, p->keep(enable_lopt), "enable the given features", nullptr, CA_VT_LIST, features);
+  p->disable_slot = p->add_opt(
+    0, p->keep(disable_lopt), "disable the given features", nullptr, CA_VT_LIST,
+    features);
   return CA_ALLOK;
 }
 
+/**
+ * \brief check a feature by name, using a FeatureHandle is faster
+ * \param feature the name of the feature
+ * \return whether the feature is enabled, false if there is no such feature
+ */
+bool
+CheckArg::enabled(const string &feature) const {
+  auto entry = p->features.find(feature);
+  if (!entry) return false;
+  size_t index = entry - p->features.entries().data();
+  return (p->feature_bits[index / 64].load(std::memory_order_relaxed) >> (index % 64)) & 1;
+}
 
 /**
  * \brief add auto generated '-\-help' message
@@ -453,16 +1003,47 @@ CheckArg::add(
  */
 int
 CheckArg::add_autohelp() {
-  p->valid_args["help"] = {
-    .value_type = CA_VT_NONE,  // add --help with no value
-    .sopt       = 'h',
-    .cb         = checkarg::show_autohelp,  // set the autohelp callback
-    .help       = "show this help message and exit",
-  };
-  p->short2long['h'] = "help";  // add -h mapped to --help
+  // add --help and -h with no value and the autohelp callback
+  p->add_opt(
+    'h', "help", "show this help message and exit", checkarg::show_autohelp,
+    CA_VT_NONE, {});
+  return CA_ALLOK;
+}
+
+/**
+ * \brief keep a flag up to date with the value of an option
+ *
+ * After every successful parse(), the flag gets the value of the option,
+ * or its default if the option wasn't given. parse() fails with CA_BADVAL
+ * if the value can't be converted, then no flag is changed.
+ * The flag must outlive this CheckArg.
+ * \param lopt long name of an option already added
+ * \param flag the flag to update
+ * \param runtime_mutable whether an AdminServer may change the flag
+ * \return CA_ALLOK, or CA_INVOPT if there is no such option
+ */
+int
+CheckArg::bind(const string &lopt, checkarg::FlagBase &flag, bool runtime_mutable) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+
+  flag.flag_name       = p->names[slot];
+  flag.runtime_mutable = runtime_mutable;
+  p->flags.emplace_back(slot, &flag);
   return CA_ALLOK;
 }
 
+/**
+ * \brief get all flags bound to options
+ * \see bind()
+ */
+vector<checkarg::FlagBase *>
+CheckArg::flags() const {
+  vector<checkarg::FlagBase *> result;
+  for (auto [slot, flag] : p->flags) result.push_back(flag);
+  return result;
+}
+
 /**
  * \brief reset internal state after a parse
  * this is automatically called by Checkarg::parse() if you call it twice
@@ -473,11 +1054,24 @@ CheckArg::reset() {
   // clear and reset positional args in case of reuse / a second parse
   p->pos_arg_sep = false;
   p->pos_args.clear();
+  p->pos_indices.clear();
+  p->path_errors.clear();
+  for (auto &opt : p->path_opts) opt.index = -1;
   // clear this in case it was set last time
-  p->next_is_val_of.clear();
-
-  // clear values and isset-state
-  for (auto &opt : p->valid_args) { opt.second.value.clear(); }
+  p->next_is_val_of = no_slot;
+  p->error          = {};
+  p->adhoc.clear();
+  for (auto &[slot, dict] : p->dicts) dict.clear();
+  for (auto &[slot, list] : p->lists) list.clear();  // keeps the capacity
+  p->enable_srcs.clear();
+  p->disable_srcs.clear();
+
+  // values of the last parse become stale by starting a new generation,
+  // only if it wraps around, the stamps need to be cleared
+  if (++p->generation == 0) {
+    for (auto &opt : p->opts) { opt.seen = 0; }
+    p->generation = 1;
+  }
 
   p->cleared = true;
 }
@@ -492,10 +1086,20 @@ CheckArg::reset() {
  */
 int
 CheckArg::parse(int argc, char **argv) {
-  if (argv == nullptr) {
-    return p->ca_error(CA_ERROR, ": argv must have at least one element!");
+  if (argv == nullptr || argc < 1 || argv[0] == nullptr) return empty_argv_error();
+
+  keep_argv(argv, nullptr, argc);
+  if (p->use_cache()) {
+    return p->parse_cached(argc, [argv](int i) { return std::string_view(argv[i]); });
   }
-  return parse(vector<string>(argv, argv + argc));
+  if (p->use_parallel(argc)) {
+    return p->parse_parallel(argc, [argv](int i) { return std::string_view(argv[i]); });
+  }
+
+  int ret = parse_begin(argv[0]);
+  // start with 1 here, because argv[0] is special
+  for (int i = 1; ret == CA_ALLOK && i < argc; ++i) { ret = parse_arg(argv[i], i); }
+  return parse_end(ret);
 }
 
 /**
@@ -508,51 +1112,598 @@ CheckArg::parse(int argc, char **argv) {
 int
 CheckArg::parse(const vector<string> &argv) {
   // FIXME: return a ParsedArgs object or something?
-  int ret = CA_ALLOK;
+  if (argv.size() == 0) return empty_argv_error();
 
-  if (argv.size() == 0) {
-    return p->ca_error(CA_ERROR, ": argv must have at least one element!");
+  int argc = argv.size();
+  keep_argv(nullptr, argv.data(), argc);
+  if (p->use_cache()) {
+    return p->parse_cached(argc, [&argv](int i) { return std::string_view(argv[i]); });
   }
-
-  if (!p->cleared) reset();
-  p->cleared = false;  // we'll soon have state again
-
-  p->callname = argv[0];
-
-#ifdef HAS_STD_FILESYSTEM
-  if (p->appname.empty()) {
-    p->appname = fs::path(p->callname).filename();
-    if (p->usage_line.empty()) p->usage_line = p->appname + " [options]";
+  if (p->use_parallel(argc)) {
+    return p->parse_parallel(argc, [&argv](int i) { return std::string_view(argv[i]); });
   }
-#endif
 
+  int ret = parse_begin(argv[0]);
   // for(auto &arg : p->argv | std::views::drop(1)) {
   // start with 1 here, because argv[0] is special
-  auto end = argv.cend();
-  for (auto arg = argv.cbegin() + 1; arg != end; ++arg) {
-    ret = p->arg(*arg);
-    if (ret != CA_ALLOK) goto error;
-  }
-  if (!p->next_is_val_of.empty()) {
-    return p->ca_error(CA_MISSVAL, ": %s!", argv.back().c_str());
+  for (int i = 1; ret == CA_ALLOK && i < argc; ++i) { ret = parse_arg(argv[i], i); }
+  return parse_end(ret);
+}
+
+/**
+ * \brief parse the command line, removing the options this CheckArg knows
+ *
+ * Known options and their values are removed from argv in place.
+ * Unknown options, positional args and a '-\-' with everything after it are
+ * kept in order, so they can be passed on to execv() or another parser.
+ * argc is updated and argv[argc] set to nullptr, like for main().
+ * If parsing fails, argv keeps everything from the failing argument on.
+ * \param argc the number of arguments, updated to the number kept
+ * \param argv the arguments, it must have room for argc + 1 pointers
+ * \return CA_ALLOK on success, some other code from CAError otherwise
+ */
+int
+CheckArg::parse_consume(int &argc, char **argv) {
+  if (argv == nullptr || argc < 1 || argv[0] == nullptr) return empty_argv_error();
+  keep_argv(nullptr, nullptr, 0);  // argv changes, so positional args are collected
+
+  int ret  = parse_begin(argv[0]);
+  int kept = 1;
+  int i    = 1;
+  for (; ret == CA_ALLOK && i < argc; ++i) {
+    std::string_view arg = argv[i];
+    // values are removed with their option, positional args and '--' are kept
+    bool keep = p->next_is_val_of == no_slot;
+    if (keep && !p->pos_arg_sep && (p->classify(arg) & CheckArgPrivate::AK_OPTION)) {
+      if (!p->known_option(arg)) {
+        // not parsed, but untrusted input may consist of nothing else
+        if (p->has_limits && (ret = p->check_limits(arg, i)) != CA_ALLOK) break;
+        argv[kept++] = argv[i];  // leave it for whoever gets argv next
+        continue;
+      }
+      keep = false;
+    }
+
+    ret = parse_arg(arg, i);
+    if (ret != CA_ALLOK) break;
+    if (keep) argv[kept++] = argv[i];
   }
 
-error:
-  return ret;
+  for (; i < argc; ++i) argv[kept++] = argv[i];  // on error, the rest stays
+  argc       = kept;
+  argv[argc] = nullptr;
+  return parse_end(ret);
+}
+
+/**
+ * \brief parse huge command lines using multiple threads
+ *
+ * Command lines with at least 16k arguments are then classified in parallel,
+ * positional args are copied in parallel, too.
+ * Options are still applied in order, so values, positional args, callbacks and
+ * errors are the same as when parsing sequentially.
+ * Only callbacks won't see the positional args given before their option.
+ * Paths checked by set_path_check() use these threads from 256 paths on.
+ * \param threads number of threads to use, 0 uses one per core, 1 disables this
+ */
+void
+CheckArg::set_parse_threads(unsigned threads) {
+  p->parse_threads = threads;
+}
+
+/**
+ * \brief bound the work a parse may do, for parsing untrusted input
+ *
+ * Limits are checked for every argument and before every callback,
+ * a parse exceeding one fails with CA_LIMIT and error().detail telling which.
+ * Parsing with limits never uses multiple threads.
+ * \param limits the limits to use from now on, all 0 to disable them
+ */
+void
+CheckArg::set_limits(const checkarg::Limits &limits) {
+  p->limits     = limits;
+  p->has_limits = limits.max_args || limits.max_arg_length || limits.max_total_bytes
+                  || limits.max_callbacks || limits.max_time.count();
+}
+
+/**
+ * \brief accept long options that weren't added
+ *
+ * Long options not known to this CheckArg are then collected instead of
+ * failing with CA_INVOPT, copied once the parse ends, so they stay valid
+ * until the next parse. value() and isset() find them, as does adhoc_options().
+ * Their value can only be given like `--key=value`.
+ * Unknown short options are still errors.
+ * \param opportunistic whether to accept unknown long options
+ */
+void
+CheckArg::set_opportunistic(bool opportunistic) {
+  p->opportunistic = opportunistic;
+}
+
+/**
+ * \brief don't collect positional args while parsing
+ *
+ * pos_args() will then always be empty, pos_args_range() finds them
+ * when iterating over it, without allocating anything.
+ * \param lazy true to stop collecting positional args
+ * \see pos_args_range()
+ */
+void
+CheckArg::set_lazy_pos_args(bool lazy) {
+  p->lazy_pos_args = lazy;
+}
+
+/**
+ * \brief cache parse results on disk, for tools run with the same argv often
+ *
+ * parse(argc, argv) and parse(vector) then look for a record of parsing the
+ * same argv with the same options in dir. If there is one, values and
+ * positional args are taken from it and no callbacks are called.
+ * Otherwise argv is parsed and, if that succeeds, a record is written.
+ * Callbacks should store what they derive from a value using set_value(),
+ * everything else they do is not repeated on a hit.
+ * Parsing with limits, opportunistically or with path checks never uses the cache.
+ * Records hold the whole argv, including any secrets passed on the command line,
+ * they are created readable by the current user only.
+ * \param dir an existing directory for the records, empty to disable caching
+ */
+void
+CheckArg::set_cache_dir(const std::string &dir) {
+  p->cache_dir = dir;
+}
+
+void
+CheckArg::keep_argv(char *const *ptrs, const std::string *strs, int argc) {
+  // only lazy positional args are looked up in argv again
+  p->argv_ptrs = p->lazy_pos_args ? ptrs : nullptr;
+  p->argv_strs = p->lazy_pos_args ? strs : nullptr;
+  p->argc      = argc;
+}
+
+int
+CheckArg::empty_argv_error() {
+  return p->ca_error(CA_ERROR, "argv must have at least one element");
+}
+
+int
+CheckArg::parse_begin(std::string_view argv0) {
+  if (!p->cleared) reset();
+  p->cleared = false;  // we'll soon have state again
+  p->error   = {};
+  // lookups must not sort while parsing, another thread might be using the index
+  if (!p->valid_args_sorted) p->sort_valid_args();
+
+  p->callname = argv0;
+  CA_PROBE(parse__start, argv0.data(), argv0.size());
+
+  if (p->has_limits) {
+    p->total_bytes = 0;
+    p->cb_count    = 0;
+    if (p->limits.max_time.count())
+      p->deadline = std::chrono::steady_clock::now() + p->limits.max_time;
+    if (int ret = p->check_limits(argv0, 0); ret != CA_ALLOK) return ret;
+  }
+
+#ifdef HAS_STD_FILESYSTEM
+  if (p->appname.empty()) {
+    p->appname = fs::path(p->callname).filename();
+    if (p->usage_line.empty()) p->usage_line = p->appname + " [options]";
+  }
+#endif
+  return CA_ALLOK;
+}
+
+std::string_view
+CheckArg::copy_arg(std::string_view arg, int index) {
+  // a deque never moves its elements, so earlier copies stay valid
+  while (p->range_args.size() <= size_t(index)) p->range_args.emplace_back();
+  return p->range_args[index].assign(arg);
+}
+
+int
+CheckArg::parse_arg(std::string_view arg, int index) {
+  p->cur_index = index;
+  if (p->has_limits) {
+    if (int ret = p->check_limits(arg, index); ret != CA_ALLOK) return ret;
+  }
+  return p->arg(arg);
+}
+
+int
+CheckArgPrivate::check_limits(std::string_view arg, int index) {
+  const char *exceeded = nullptr;
+  total_bytes += arg.size();
+  if (limits.max_args && size_t(index) >= limits.max_args) exceeded = "too many arguments";
+  else if (limits.max_arg_length && arg.size() > limits.max_arg_length)
+    exceeded = "argument too long";
+  else if (limits.max_total_bytes && total_bytes > limits.max_total_bytes)
+    exceeded = "arguments too long in total";
+  else if (limits.max_time.count() && std::chrono::steady_clock::now() > deadline)
+    exceeded = "parsing took too long";
+
+  if (exceeded) return ca_error({.code = CA_LIMIT, .index = index, .detail = exceeded});
+  return CA_ALLOK;
+}
+
+int
+CheckArg::parse_end(int ret) {
+  // errors found after the parse loop, like by check_paths(), don't end it early
+  auto &error    = p->error;
+  p->parsed_argc = ret != CA_ALLOK && error.index >= 0 ? error.index : p->argc;
+  // argv may be gone before adhoc options are looked up
+  if (!p->adhoc.entries().empty()) p->adhoc.own(p->adhoc_text);
+  if (ret == CA_ALLOK && p->next_is_val_of != no_slot) {
+    ret = p->ca_error(p->next_is_val_src);
+  }
+  if (ret == CA_ALLOK) p->apply_env();
+  if (ret == CA_ALLOK) ret = p->check_constraints();
+  if (ret == CA_ALLOK) ret = p->check_paths();
+  if (ret == CA_ALLOK) ret = p->resolve_features();
+  if (ret == CA_ALLOK) ret = p->publish_flags();
+  CA_PROBE(parse__end, ret);
+  return ret;
+}
+
+namespace {
+
+// why path fails checks, null if it doesn't
+const char *
+check_path(std::string_view path, uint8_t checks, string &name) {
+  name.assign(path);  // views into argv ranges need not end in a NUL
+  struct stat st;
+  if (::stat(name.c_str(), &st) < 0) {
+    return errno == ENOENT ? "no such file or directory" : "can't access it";
+  }
+  bool is_file = S_ISREG(st.st_mode), is_dir = S_ISDIR(st.st_mode);
+  if ((checks & checkarg::PC_FILE) && (checks & checkarg::PC_DIR)) {
+    if (!is_file && !is_dir) return "not a file or directory";
+  }
+  else if ((checks & checkarg::PC_FILE) && !is_file) return "not a regular file";
+  else if ((checks & checkarg::PC_DIR) && !is_dir) return "not a directory";
+  if ((checks & checkarg::PC_READABLE) && ::access(name.c_str(), R_OK) < 0) {
+    return "not readable";
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+int
+CheckArgPrivate::check_paths() {
+  path_errors.clear();
+  if (path_opts.empty() && !pos_path_checks) return CA_ALLOK;
+
+  path_jobs.clear();
+  for (auto &opt : path_opts) {
+    auto path = value_of(opt.slot);
+    if (!path.data()) continue;
+    if (opts[opt.slot].value_type == CA_VT_FILE && path.starts_with('@'))
+      path.remove_prefix(1);  // like file() does
+    int index = is_seen(opt.slot) && !from_env(opt.slot) ? opt.index : -1;
+    path_jobs.push_back({.path = path, .index = index, .checks = opt.checks});
+  }
+  for (size_t k = 0; k < pos_indices.size(); ++k) {
+    int index = pos_indices[k];
+    auto path = argv_kept() ? parent->argv_at(index) : std::string_view(pos_args[k]);
+    path_jobs.push_back({.path = path, .index = index, .checks = pos_path_checks});
+  }
+
+  // stat() mostly waits, so threads pay off much earlier than for parsing
+  constexpr size_t min_paths = 256;
+  unsigned threads           = parse_threads;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  if (path_jobs.size() < min_paths) threads = 1;
+
+  // threads take chunks as they go, as some paths take much longer than others
+  constexpr size_t chunk = 64;
+  std::atomic<size_t> next{0};
+  auto work = [&](unsigned) {
+    string name;
+    for (size_t begin; (begin = next.fetch_add(chunk)) < path_jobs.size();) {
+      size_t end = std::min(begin + chunk, path_jobs.size());
+      for (size_t i = begin; i < end; ++i) {
+        auto &job  = path_jobs[i];
+        job.failed = check_path(job.path, job.checks, name);
+      }
+    }
+  };
+  vector<std::thread> workers;
+  for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work, t);
+  work(0u);
+  for (auto &worker : workers) worker.join();
+
+  for (auto &job : path_jobs) {
+    if (!job.failed) continue;
+    path_errors.push_back(
+      {.code = CA_PATH, .index = job.index, .option = job.path, .detail = job.failed});
+  }
+  if (path_errors.empty()) return CA_ALLOK;
+  std::stable_sort(path_errors.begin(), path_errors.end(), [](auto &a, auto &b) {
+    return unsigned(a.index) < unsigned(b.index);  // -1 goes last
+  });
+  return ca_error(path_errors.front());
+}
+
+int
+CheckArgPrivate::resolve_features() {
+  // built aside and published word by word, so readers never see a half-applied list
+  feature_scratch = feature_defaults;  // the same size, so nothing is allocated
+  // disabling wins, so it is done last
+  for (auto [slot, enable] : {std::pair{enable_slot, true}, {disable_slot, false}}) {
+    if (slot == no_slot || !is_seen(slot)) continue;
+    auto &list = *list_of(slot);
+    auto &srcs = enable ? enable_srcs : disable_srcs;
+    for (size_t i = 0; i < list.size(); ++i) {
+      auto name = list[i];
+      if (name.empty()) continue;  // like --enable-features=A,,B
+      auto entry = features.find(name);
+      if (!entry) {
+        publish_features(feature_defaults);
+        auto [index, offset] = i < srcs.size() ? srcs[i] : std::pair{-1, size_t(0)};
+        return ca_error(
+          {.code = CA_INVFEATURE, .index = index, .offset = offset, .option = name});
+      }
+      size_t index = entry - features.entries().data();
+      uint64_t bit = uint64_t(1) << (index % 64);
+      if (enable) feature_scratch[index / 64] |= bit;
+      else feature_scratch[index / 64] &= ~bit;
+    }
+  }
+  publish_features(feature_scratch);
+  return CA_ALLOK;
+}
+
+void
+CheckArgPrivate::publish_features(const std::vector<uint64_t> &words) {
+  for (size_t i = 0; i < words.size(); ++i)
+    feature_bits[i].store(words[i], std::memory_order_relaxed);
+}
+
+std::string_view
+CheckArgPrivate::value_of(uint32_t slot) const {
+  if (from_env(slot)) return env_values[slot].second;
+  if (is_seen(slot)) return values[slot];
+  return defaults[slot];
+}
+
+void
+CheckArgPrivate::apply_env() {
+  if (env_binds.entries().empty() && env_prefix.empty()) return;
+  if (env_values.size() < opts.size()) env_values.resize(opts.size());
+
+  // a single pass, however many options and variables there are
+  for (char **env = environ; env && *env; ++env) {
+    std::string_view entry = *env;
+    auto eqpos             = find_char(entry, '=');
+    if (eqpos == std::string_view::npos) continue;
+    auto name = entry.substr(0, eqpos);
+
+    uint32_t slot = no_slot;
+    bool bound    = false;
+    if (auto bind = env_binds.find(name)) {
+      slot  = env_bind_slots[bind - env_binds.entries().data()];
+      bound = true;
+    }
+    else if (!env_prefix.empty() && name.size() > env_prefix.size()
+             && name.starts_with(env_prefix)) {
+      // APP_OUTPUT_FORMAT is --output-format
+      env_name.assign(name.substr(env_prefix.size()));
+      for (auto &c : env_name) c = c == '_' ? '-' : std::tolower((unsigned char)c);
+      slot = find(env_name);
+      auto type = slot != no_slot ? opts[slot].value_type : CA_VT_NONE;
+      if (type && !single_value(type)) slot = no_slot;
+    }
+    if (slot == no_slot) continue;
+
+    // the command line wins, and a bound variable over a prefixed one
+    if (is_seen(slot) && (!from_env(slot) || !bound)) continue;
+    auto value = entry.substr(eqpos + 1);
+    if (!opts[slot].value_type && (value.empty() || value == "0")) continue;
+    env_values[slot] = {generation, value};
+    mark_seen(slot);
+  }
+}
+
+int
+CheckArgPrivate::publish_flags() {
+  auto text = [this](uint32_t slot) -> std::string_view {
+    if (is_seen(slot) && !opts[slot].value_type) return "1";
+    return value_of(slot);
+  };
+  // check all of them first, so a bad value does not leave some flags updated
+  for (auto [slot, flag] : flags) {
+    if (text(slot).data() && !flag->check(text(slot))) {
+      return ca_error({.code = CA_BADVAL, .offset = 2, .option = names[slot]});
+    }
+  }
+  for (auto [slot, flag] : flags) {
+    if (text(slot).data()) flag->store(text(slot));
+    else flag->store_default();
+  }
+  return CA_ALLOK;
 }
 
 
 /**
  * \brief get the value of a given option
  * \warning you shouldn't call this before parse()!
+ * Options without a value have an empty one, use isset() to check for them.
  * \param arg the long name of the option to get the value of
  * \return the value
  */
 string
 CheckArg::value(const string &arg) const {
-  auto pos = p->valid_args.find(arg);
-  if (pos != p->valid_args.end()) { return pos->second.value; }
-  return "";
+  return string(value_view(arg));
+}
+
+/**
+ * \brief get the value of a given option without copying it
+ *
+ * The view is valid until the next parse() or reset(), a default one
+ * as long as this CheckArg.
+ * \warning you shouldn't call this before parse()!
+ * \param arg the long name of the option to get the value of
+ * \return the value, its default if it wasn't given, or empty
+ * \see set_default()
+ */
+std::string_view
+CheckArg::value_view(const string &arg) const {
+  auto slot = p->find(arg);
+  if (slot != no_slot) return p->value_of(slot);
+  if (p->opportunistic) {
+    if (auto entry = p->adhoc.find(arg)) return entry->second;
+  }
+  return {};
+}
+
+/**
+ * \brief get the value of a key given to a CA_VT_DICT option
+ *
+ * Each time such an option is given, like `-Dkey=value` or `--define key=value`,
+ * its value is split at the first '=' into a key and a value.
+ * \warning you shouldn't call this before parse()!
+ * \param lopt the long name of the option
+ * \param key the key to get the value of
+ * \return the value last given for key, empty if it wasn't given
+ */
+string
+CheckArg::value(const string &lopt, std::string_view key) const {
+  auto slot = p->find(lopt);
+  if (slot == no_slot || !p->is_seen(slot)) return "";
+  auto dict = p->dict_of(slot);
+  if (!dict) return "";
+  auto entry = dict->find(key);
+  return entry ? string(entry->second) : "";
+}
+
+/**
+ * \brief get all keys and values given to a CA_VT_DICT option
+ *
+ * The views point into the argv given to parse(),
+ * they are valid until the next parse() or reset().
+ * \param lopt the long name of the option
+ * \return the pairs of keys and values in the order first given,
+ *         empty if lopt is no CA_VT_DICT option
+ */
+std::span<const std::pair<std::string_view, std::string_view>>
+CheckArg::dict(const string &lopt) const {
+  auto slot = p->find(lopt);
+  if (slot == no_slot || !p->is_seen(slot)) return {};
+  auto dict = p->dict_of(slot);
+  if (!dict) return {};
+  return dict->entries();
+}
+
+/**
+ * \brief get the items given to a CA_VT_LIST option
+ *
+ * Each time such an option is given, its value is split at the delimiter,
+ * so `--tags=a,b --tags c` gives the items a, b and c.
+ * An empty value adds no items, empty items between delimiters are kept.
+ * The views point into the argv given to parse(),
+ * they are valid until the next parse() or reset().
+ * \param lopt the long name of the option
+ * \return the items in the order given, empty if lopt is no CA_VT_LIST option
+ * \see set_delimiter()
+ */
+std::span<const std::string_view>
+CheckArg::values(const string &lopt) const {
+  auto slot = p->find(lopt);
+  if (slot == no_slot || !p->is_seen(slot)) return {};
+  auto list = p->list_of(slot);
+  if (!list) return {};
+  return *list;
+}
+
+/**
+ * \brief get the contents of the file given to a CA_VT_FILE option
+ *
+ * The value names a file, like `--dict=@words.txt`, a leading '@' is dropped.
+ * The file is mapped read-only when its contents are first asked for,
+ * and stays mapped for as long as this CheckArg, so asking again is cheap.
+ * Files that were never asked for are never opened.
+ * \param lopt the long name of the option
+ * \param contents set to the contents of the file
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL if it is no CA_VT_FILE option,
+ *         CA_MISSVAL if it was not given and has no default,
+ *         CA_ERROR with errno telling why, if the file can't be read
+ */
+int
+CheckArg::file(const string &lopt, std::span<const char> &contents) const {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  if (p->opts[slot].value_type != CA_VT_FILE) return CA_INVVAL;
+  auto path = p->value_of(slot);
+  if (!path.data()) return CA_MISSVAL;
+  if (path.starts_with('@')) path.remove_prefix(1);
+
+  std::string_view mapped;
+  int ret = p->map_file(path, mapped);
+  if (ret == CA_ALLOK) contents = {mapped.data(), mapped.size()};
+  return ret;
+}
+
+int
+CheckArgPrivate::map_file(std::string_view path, std::string_view &contents) {
+  if (auto entry = files.find(path)) {
+    contents = entry->second;
+    return CA_ALLOK;
+  }
+
+  string name(path);
+#ifdef HAS_SYS_MMAN
+  int fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return CA_ERROR;
+  struct stat st;
+  void *data = nullptr;
+  int err    = 0;
+  if (::fstat(fd, &st) < 0) err = errno;
+  else if (!S_ISREG(st.st_mode)) err = EINVAL;  // pipes and the like can't be mapped
+  else if (st.st_size > 0) {
+    data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) err = errno;
+  }
+  ::close(fd);
+  if (err) {
+    errno = err;
+    return CA_ERROR;
+  }
+  contents = {static_cast<const char *>(data), data ? size_t(st.st_size) : 0};
+#else
+  // without mmap the file is read once into memory kept as long
+  std::ifstream in(name, std::ios::binary | std::ios::ate);
+  if (!in) return CA_ERROR;
+  auto size   = size_t(in.tellg());
+  char *block = size ? blocks.emplace_back(new char[size]).get() : nullptr;
+  in.seekg(0);
+  if (size && !in.read(block, size)) return CA_ERROR;
+  contents = {block, size};
+#endif
+  files.set(keep(std::move(name)), contents);
+  return CA_ALLOK;
+}
+
+/**
+ * \brief replace the value of an option, marking it as given
+ *
+ * Callbacks can use this to store a normalized value, which is then
+ * also what the parse cache keeps.
+ * \param lopt the long name of the option
+ * \param value the new value
+ * \return CA_ALLOK, CA_INVOPT if there is no such option,
+ *         CA_INVVAL if it does not take a single value
+ * \see set_cache_dir()
+ */
+int
+CheckArg::set_value(const string &lopt, const string &value) {
+  auto slot = p->find(lopt);
+  if (slot == no_slot) return CA_INVOPT;
+  if (!checkarg::single_value(p->opts[slot].value_type)) return CA_INVVAL;
+  p->values[slot] = value;
+  p->mark_seen(slot);
+  return CA_ALLOK;
 }
 
 /**
@@ -562,8 +1713,21 @@ CheckArg::value(const string &arg) const {
  */
 bool
 CheckArg::isset(const string &arg) const {
-  auto pos = p->valid_args.find(arg);
-  return pos != p->valid_args.end() && !(pos->second.value.empty());
+  auto slot = p->find(arg);
+  if (slot == no_slot && p->opportunistic) return p->adhoc.find(arg) != nullptr;
+  return slot != no_slot && p->is_seen(slot);
+}
+
+/**
+ * \brief get the long options given, that weren't added
+ *
+ * Only collected if set_opportunistic() was used,
+ * names and values are copies, valid until the next parse().
+ * \return pairs of name and value, in the order they were first given
+ */
+std::span<const std::pair<std::string_view, std::string_view>>
+CheckArg::adhoc_options() const {
+  return p->adhoc.entries();
 }
 
 /**
@@ -606,12 +1770,14 @@ CheckArg::_autohelp() {
  */
 string
 CheckArg::autohelp() {
+  if (!p->valid_args_sorted) p->sort_valid_args();
+
   stringstream ss;
   size_t space = 0;
   for (auto &kv : p->valid_args) {
     size_t vsize = 0;
-    if (kv.second.value_type != CA_VT_NONE) {
-      vsize = kv.second.value_name.size();
+    if (p->opts[kv.second].value_type != CA_VT_NONE) {
+      vsize = p->opt_help[kv.second].value_name.size();
       // FIXME: maybe always show equals sign to mark value options with empty name?
       if (vsize > 0) ++vsize;  // account for the equals sign
     }
@@ -626,7 +1792,8 @@ CheckArg::autohelp() {
 
   ss << endl << "Options:" << endl;
   for (auto it = p->valid_args.begin(); it != p->valid_args.end(); ++it) {
-    auto opt = it->second;
+    auto &opt  = p->opts[it->second];
+    auto &help = p->opt_help[it->second];
 
     if (opt.sopt)
       ss << "   -" << opt.sopt << ",";
@@ -637,25 +1804,30 @@ CheckArg::autohelp() {
 
     switch (opt.value_type) {
     // case CA_VT_OPTIONAL:
-    // if (!opt.value_name.empty()) {
-    //   ss << "=[" << opt.value_name << "]"
-    //      << string(space - it->first.size() - opt.value_name.size() - 3, ' ');
+    // if (!help.value_name.empty()) {
+    //   ss << "=[" << help.value_name << "]"
+    //      << string(space - it->first.size() - help.value_name.size() - 3, ' ');
     //   break;
     // }
-    // // fallthrough to default is intended
+    // [[fallthrough]];
     case CA_VT_REQUIRED:
-      if (!opt.value_name.empty()) {
-        ss << "=" << opt.value_name
-           << string(space - it->first.size() - opt.value_name.size() - 1, ' ');
+    case CA_VT_DICT:
+    case CA_VT_LIST:
+    case CA_VT_FILE:
+      if (!help.value_name.empty()) {
+        ss << "=" << help.value_name
+           << string(space - it->first.size() - help.value_name.size() - 1, ' ');
         break;
       }
-      // fallthrough to default is intended
+      [[fallthrough]];  // to default, if there is no value name
     default:
       ss << string(space - it->first.size(), ' ');
       break;
     }
 
-    ss << opt.help << endl;
+    ss << help.help;
+    if (auto def = p->defaults[it->second]; def.data()) ss << " (default: " << def << ")";
+    ss << endl;
   }
   if (!p->posarg_help_descr.empty())
     ss << endl << "Positional Arguments:" << endl << p->posarg_help_descr << endl;
@@ -676,22 +1848,23 @@ CheckArg::show_help() {
 // private members:
 
 int
-CheckArgPrivate::arg(const string &arg) {
+CheckArgPrivate::arg(std::string_view arg) {
+  cur_arg = arg;
   if (!pos_arg_sep) {
     // if the separator '--' was given, all following args are positional
 
-    if (!next_is_val_of.empty()) {
+    if (next_is_val_of != no_slot) {
       // _next val of should be an opt with value
       // static_assert( _valid_args[_next_is_val_of].value_type );
 
-      valid_args[next_is_val_of].value = arg;
-      auto ret                         = call_cb(next_is_val_of);
-      next_is_val_of.clear();
-      return ret;
+      auto slot      = next_is_val_of;
+      next_is_val_of = no_slot;
+      store_value(slot, arg);
+      return call_cb(slot);
     }
 
-    if (arg[0] == '-') {    // it's an arg
-      if (arg[1] == '-') {  // it's a long one
+    if (!arg.empty() && arg[0] == '-') {        // it's an arg
+      if (arg.size() > 1 && arg[1] == '-') {  // it's a long one
         return arg_long(arg.substr(2));
       }
 
@@ -701,144 +1874,760 @@ CheckArgPrivate::arg(const string &arg) {
   }
 
   // it's some positional arg
-  pos_args.push_back(arg);
+  if (!argv_kept()) pos_args.emplace_back(arg);
+  if (pos_path_checks) pos_indices.push_back(cur_index);
   return CA_ALLOK;
 }
 
 int
-CheckArgPrivate::arg_long(const string &arg) {
+CheckArgPrivate::arg_long(std::string_view arg) {
   if (arg.empty()) {
     // if the given arg was '--', arg is an empty string
     pos_arg_sep = true;
     return CA_ALLOK;
   }
 
-  auto eqpos = arg.find('=');
-  string real_arg, val;
-  if (eqpos != string::npos) {
-    real_arg = arg.substr(0, eqpos);
-    val      = arg.substr(eqpos + 1);
-  }
-  else {
-    real_arg = arg;
-  }
-
-  auto pos = valid_args.find(real_arg);
-  if (pos != valid_args.end()) {
-    if (pos->second.value_type && eqpos != string::npos) {
+  auto eqpos    = find_char(arg, '=');
+  bool has_val  = eqpos != std::string_view::npos;
+  auto real_arg = arg.substr(0, eqpos);
+  std::string_view val;
+  if (has_val) val = arg.substr(eqpos + 1);
+
+  auto slot = find(real_arg);
+  if (slot != no_slot) {
+    CA_PROBE(option__match, names[slot].data(), names[slot].size(), 0);
+    auto &opt = opts[slot];
+    if (opt.value_type && has_val) {
       // arg has value defined, and value is given by '='
-      pos->second.value = val;
+      store_value(slot, val);
     }
-    else if (pos->second.value_type) {
+    else if (opt.value_type) {
       // value of arg is the next arg, remember that for the next call of arg
-      next_is_val_of = real_arg;
+      next_is_val_of  = slot;
+      next_is_val_src = {
+        .code = CA_MISSVAL, .index = cur_index, .offset = 2, .option = real_arg};
     }
     else {  // there's no value defined by add()
       if (!val.empty()) {
         // error?
-        return ca_error(CA_INVVAL, ": --%s!", real_arg.c_str());
+        return ca_error(
+          {.code = CA_INVVAL, .index = cur_index, .offset = 2, .option = real_arg});
       }
-      pos->second.value = "x";  // mark arg as seen
+      mark_seen(slot);
     }
 
-    if (!pos->second.value_type || !val.empty()) {
-      // if arg has no val, or val is found already, call callback now, if there's one
-      return call_cb(real_arg);
+    if (!opt.value_type || has_val) {
+      // if arg has no val, or val is found already, even an empty one,
+      // call callback now, if there's one
+      return call_cb(slot);
     }
     return CA_ALLOK;
   }
+  else if (opportunistic) {
+    adhoc.set(real_arg, val);
+    return CA_ALLOK;
+  }
   else {
-    return ca_error(CA_INVOPT, ": --%s!", real_arg.c_str());
+    return ca_error({
+      .code       = CA_INVOPT,
+      .index      = cur_index,
+      .offset     = 2,
+      .option     = real_arg,
+      .suggestion = suggest(real_arg),
+    });
   }
 }
 
 int
-CheckArgPrivate::arg_short(const string &arg) {
+CheckArgPrivate::arg_short(std::string_view arg) {
   size_t len = arg.size();
   for (size_t i = 0; i < len; ++i) {
-    auto pos = short2long.find(arg[i]);
-    if (pos != short2long.end()) {               // there is such a short arg registered
-      if (valid_args[pos->second].value_type) {  // if has val,
-        if (i < len - 1) {                       // remainder is interpreted as val,
-          valid_args[pos->second].value = arg.substr(i + 1);
-          return call_cb(pos->second);
+    auto slot = short2slot[(unsigned char)arg[i]];
+    if (slot != no_slot) {               // there is such a short arg registered
+      CA_PROBE(option__match, names[slot].data(), names[slot].size(), arg[i]);
+      if (opts[slot].value_type) {       // if has val,
+        if (i < len - 1) {               // remainder is interpreted as val,
+          store_value(slot, arg.substr(i + 1));
+          return call_cb(slot);
         }
         else {  // or next_arg is treated as val
-          next_is_val_of = pos->second;
+          next_is_val_of  = slot;
+          next_is_val_src = {
+            .code     = CA_MISSVAL,
+            .index    = cur_index,
+            .offset   = i + 1,
+            .option   = arg.substr(i, 1),
+            .is_short = true,
+          };
         }
         return CA_ALLOK;  // no further looping, we're done.
       }
       else {
-        valid_args[pos->second].value = "x";  // mark arg as seen
-        auto ret                      = call_cb(pos->second);
+        mark_seen(slot);
+        auto ret = call_cb(slot);
         if (ret != CA_ALLOK) return ret;
       }
     }
     else {
-      return ca_error(CA_INVOPT, ": -%c!", arg[i]);
+      return ca_error({
+        .code     = CA_INVOPT,
+        .index    = cur_index,
+        .offset   = i + 1,
+        .option   = arg.substr(i, 1),
+        .is_short = true,
+      });
     }
   }
   return CA_ALLOK;
 }
 
+void
+CheckArgPrivate::store_value(uint32_t slot, std::string_view val) {
+  if (opts[slot].value_type == CA_VT_DICT) {
+    // a key without '=' gets an empty value, the last one of a key wins
+    auto eqpos = find_char(val, '=');
+    auto dict  = dict_of(slot);
+    if (eqpos == std::string_view::npos) dict->set(val, {});
+    else dict->set(val.substr(0, eqpos), val.substr(eqpos + 1));
+  }
+  else if (opts[slot].value_type == CA_VT_LIST && !val.empty()) {
+    auto list = list_of(slot);
+    size_t first = list->size();
+    split_char(val, opts[slot].delimiter, *list);
+    if (slot == enable_slot || slot == disable_slot) {
+      // remember where feature names are, for errors about unknown ones
+      auto &srcs = slot == enable_slot ? enable_srcs : disable_srcs;
+      for (size_t i = first; i < list->size(); ++i)
+        srcs.emplace_back(cur_index, (*list)[i].data() - cur_arg.data());
+    }
+  }
+  values[slot] = val;  // callbacks get each occurrence here
+  mark_seen(slot);
+  for (auto &opt : path_opts)
+    if (opt.slot == slot) opt.index = cur_index;
+}
+
+checkarg::FlatMap *
+CheckArgPrivate::dict_of(uint32_t slot) {
+  // there are only ever a few of them
+  for (auto &[dict_slot, dict] : dicts)
+    if (dict_slot == slot) return &dict;
+  return nullptr;
+}
+
+const checkarg::FlatMap *
+CheckArgPrivate::dict_of(uint32_t slot) const {
+  return const_cast<CheckArgPrivate *>(this)->dict_of(slot);
+}
+
+std::vector<std::string_view> *
+CheckArgPrivate::list_of(uint32_t slot) {
+  for (auto &[list_slot, list] : lists)
+    if (list_slot == slot) return &list;
+  return nullptr;
+}
+
+const std::vector<std::string_view> *
+CheckArgPrivate::list_of(uint32_t slot) const {
+  return const_cast<CheckArgPrivate *>(this)->list_of(slot);
+}
+
+namespace {
+
+// Levenshtein distance, row is scratch space
+uint32_t
+edit_distance(std::string_view a, std::string_view b, vector<uint32_t> &row) {
+  row.resize(b.size() + 1);
+  for (uint32_t j = 0; j <= b.size(); ++j) row[j] = j;
+  for (uint32_t i = 1; i <= a.size(); ++i) {
+    uint32_t diag = row[0];  // row[j - 1] of the previous row
+    row[0]        = i;
+    for (uint32_t j = 1; j <= b.size(); ++j) {
+      uint32_t up = row[j];
+      row[j] = std::min({up + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1])});
+      diag   = up;
+    }
+  }
+  return row[b.size()];
+}
+
+}  // namespace
+
+std::string_view
+CheckArgPrivate::suggest(std::string_view name) {
+  auto &row = suggest_row;
+  if (suggest_tree.empty()) {
+    // only on the first typo, inserting along the unique edges of equal distance
+    if (!valid_args_sorted) sort_valid_args();
+    suggest_tree.reserve(valid_args.size());
+    for (auto [lopt, slot] : valid_args) {
+      if (suggest_tree.empty()) {
+        suggest_tree.push_back({.slot = slot, .dist = 0});
+        continue;
+      }
+      uint32_t node = 0;
+      while (true) {
+        uint32_t dist  = edit_distance(lopt, names[suggest_tree[node].slot], row);
+        uint32_t child = suggest_tree[node].first_child;
+        while (child != no_slot && suggest_tree[child].dist != dist)
+          child = suggest_tree[child].next_sibling;
+        if (child != no_slot) {
+          node = child;
+          continue;
+        }
+        suggest_tree.push_back({
+          .slot         = slot,
+          .dist         = dist,
+          .next_sibling = suggest_tree[node].first_child,
+        });
+        suggest_tree[node].first_child = suggest_tree.size() - 1;
+        break;
+      }
+    }
+    if (suggest_tree.empty()) return {};
+  }
+
+  // only suggest names a typo or two away, the longer the name, the more
+  uint32_t best_dist = std::min<uint32_t>(3, 1 + name.size() / 4) + 1;
+  uint32_t best      = no_slot;
+  // the triangle inequality rules out children not within best_dist of dist
+  auto &todo = suggest_todo;
+  todo.assign(1, 0);
+  while (!todo.empty()) {
+    auto &node = suggest_tree[todo.back()];
+    todo.pop_back();
+    uint32_t dist = edit_distance(name, names[node.slot], row);
+    if (dist < best_dist) {
+      best_dist = dist;
+      best      = node.slot;
+    }
+    for (auto child = node.first_child; child != no_slot;
+         child      = suggest_tree[child].next_sibling) {
+      uint32_t cdist = suggest_tree[child].dist;
+      if (cdist + best_dist > dist && cdist < dist + best_dist) todo.push_back(child);
+    }
+  }
+  return best == no_slot ? std::string_view() : names[best];
+}
+
+uint8_t
+CheckArgPrivate::classify(std::string_view arg) const {
+  // this must match what arg(), arg_long() and arg_short() do
+  if (arg.empty() || arg[0] != '-') return AK_POSITIONAL;
+
+  if (arg.size() > 1 && arg[1] == '-') {
+    if (arg.size() == 2) return AK_SEPARATOR;
+    if (find_char(arg, '=') != std::string_view::npos) return AK_OPTION;
+    auto slot = find(arg.substr(2));
+    if (slot != no_slot && opts[slot].value_type) return AK_OPTION | AK_CONSUMES;
+    return AK_OPTION;
+  }
+
+  for (size_t i = 1; i < arg.size(); ++i) {
+    auto slot = short2slot[(unsigned char)arg[i]];
+    if (slot == no_slot) break;  // an error, nothing is consumed
+    if (opts[slot].value_type) {
+      // the remainder is the value, if there is one
+      return i == arg.size() - 1 ? AK_OPTION | AK_CONSUMES : AK_OPTION;
+    }
+  }
+  return AK_OPTION;
+}
+
+bool
+CheckArgPrivate::known_option(std::string_view arg) const {
+  // whether arg() won't fail on arg as an unknown option
+  if (arg.size() < 2 || arg[0] != '-') return false;
+  if (arg[1] == '-') return find(arg.substr(2, find_char(arg, '=') - 2)) != no_slot;
+
+  for (size_t i = 1; i < arg.size(); ++i) {
+    auto slot = short2slot[(unsigned char)arg[i]];
+    if (slot == no_slot) return false;
+    if (opts[slot].value_type) return true;  // the remainder is its value
+  }
+  return true;
+}
+
+bool
+CheckArgPrivate::use_parallel(int argc) const {
+  // below that, starting threads costs more than it saves
+  constexpr int min_args = 1 << 14;
+  return parse_threads != 1 && argc >= min_args && !has_limits;
+}
+
+template<typename GetArg>
+int
+CheckArgPrivate::parse_parallel(int argc, GetArg get) {
+  int ret = parent->parse_begin(get(0));
+  if (ret != CA_ALLOK) return ret;
+
+  unsigned threads = parse_threads;
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // every parallel pass splits argv the same way
+  vector<int> bounds(threads + 1);
+  for (unsigned t = 0; t <= threads; ++t)
+    bounds[t] = 1 + int(int64_t(argc - 1) * t / threads);
+  auto run = [threads](auto &&fn) {
+    vector<std::thread> workers;
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(fn, t);
+    fn(0u);
+    for (auto &worker : workers) worker.join();
+  };
+
+  // classify each arg, as if it was not the value of the one before
+  arg_kinds.resize(argc);
+  run([&](unsigned t) {
+    for (int i = bounds[t]; i < bounds[t + 1]; ++i) arg_kinds[i] = classify(get(i));
+  });
+
+  // resolve values and a '--', applying everything but positional args in order
+  int end    = argc;
+  bool sep   = false;
+  bool value = false;
+  for (int i = 1; i < argc; ++i) {
+    uint8_t kind = arg_kinds[i];
+    if (value) { value = false; }
+    else if (sep || kind == AK_POSITIONAL) {
+      arg_kinds[i] = AK_POSITIONAL;
+      continue;
+    }
+    else {
+      sep   = kind & AK_SEPARATOR;
+      value = kind & AK_CONSUMES;
+    }
+    arg_kinds[i] = AK_OPTION;
+
+    cur_index = i;
+    ret       = arg(get(i));
+    if (ret != CA_ALLOK) {
+      end = i;  // positional args after an error are not collected
+      break;
+    }
+  }
+
+  // copy positional args, each thread into its own part of pos_args
+  if (!argv_kept()) {
+    vector<size_t> offsets(threads + 1);
+    run([&](unsigned t) {
+      size_t count = 0;
+      for (int i = bounds[t]; i < std::min(bounds[t + 1], end); ++i)
+        count += arg_kinds[i] == AK_POSITIONAL;
+      offsets[t + 1] = count;
+    });
+    for (unsigned t = 0; t < threads; ++t) offsets[t + 1] += offsets[t];
+    pos_args.resize(offsets[threads]);
+    run([&](unsigned t) {
+      size_t k = offsets[t];
+      for (int i = bounds[t]; i < std::min(bounds[t + 1], end); ++i)
+        if (arg_kinds[i] == AK_POSITIONAL) pos_args[k++] = get(i);
+    });
+  }
+  if (pos_path_checks) {
+    for (int i = 1; i < end; ++i)
+      if (arg_kinds[i] == AK_POSITIONAL) pos_indices.push_back(i);
+  }
+
+  return parent->parse_end(ret);
+}
+
+bool
+CheckArgPrivate::use_cache() const {
+  // all of them change what a record would have to contain
+  return !cache_dir.empty() && !has_limits && !opportunistic && dicts.empty()
+         && lists.empty() && !pos_path_checks && path_opts.empty();
+}
+
+namespace {
+
+// bump this when the record layout changes
+constexpr uint32_t cache_version = 1;
+constexpr char cache_magic[4]    = {'C', 'A', 'C', 'R'};
+
+uint64_t
+fnv1a(std::string_view data, uint64_t hash = 0xcbf29ce484222325) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+template<typename T>
+void
+put(string &out, T val) {
+  out.append(reinterpret_cast<const char *>(&val), sizeof(val));
+}
+
+void
+put_str(string &out, std::string_view str) {
+  put(out, uint32_t(str.size()));
+  out.append(str);
+}
+
+// reads a record, failing on the first thing not in it
+struct RecordReader {
+  std::string_view rest;
+  bool ok = true;
+
+  template<typename T>
+  T get() {
+    T val{};
+    if (rest.size() < sizeof(T)) ok = false;
+    if (!ok) return val;
+    std::memcpy(&val, rest.data(), sizeof(T));
+    rest.remove_prefix(sizeof(T));
+    return val;
+  }
+  std::string_view get_str() {
+    auto size = get<uint32_t>();
+    if (rest.size() < size) ok = false;
+    if (!ok) return {};
+    auto str = rest.substr(0, size);
+    rest.remove_prefix(size);
+    return str;
+  }
+};
+
+}  // namespace
+
+uint64_t
+CheckArgPrivate::schema_fingerprint() const {
+  // everything changing how an argv is parsed, or what a record holds
+  string schema;
+  put(schema, cache_version);
+  put(schema, lazy_pos_args);
+  for (uint32_t slot = 0; slot < opts.size(); ++slot) {
+    put_str(schema, names[slot]);
+    put(schema, opts[slot].sopt);
+    put(schema, opts[slot].value_type);
+    put(schema, opts[slot].has_cb);
+  }
+  return fnv1a(schema);
+}
+
+string
+CheckArgPrivate::cache_path(std::string_view key) const {
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.cache",
+           (unsigned long long)fnv1a(key, schema_fingerprint()));
+  return cache_dir + name;
+}
+
+// record: magic, fingerprint, key (the argv),
+// seen options as slot and value, positional args
+bool
+CheckArgPrivate::cache_load(const string &path, std::string_view key) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return false;
+  string record{std::istreambuf_iterator<char>(file), {}};
+
+  RecordReader in{record};
+  auto magic = in.rest.substr(0, sizeof(cache_magic));
+  if (magic != std::string_view(cache_magic, sizeof(cache_magic))) return false;
+  in.rest.remove_prefix(sizeof(cache_magic));
+  // the file name is only a hash, so check both
+  if (in.get<uint64_t>() != schema_fingerprint() || in.get_str() != key) return false;
+
+  // check it all before changing anything, a count can't be more than what is left
+  auto count = in.get<uint32_t>();
+  if (count > in.rest.size() / 8) return false;
+  vector<std::pair<uint32_t, std::string_view>> seen(count);
+  for (auto &[slot, value] : seen) {
+    slot  = in.get<uint32_t>();
+    value = in.get_str();
+    if (slot >= opts.size()) in.ok = false;
+  }
+  count = in.get<uint32_t>();
+  if (count > in.rest.size() / 4) return false;
+  vector<std::string_view> pos(count);
+  for (auto &arg : pos) arg = in.get_str();
+  if (!in.ok || !in.rest.empty()) return false;
+
+  for (auto [slot, value] : seen) {
+    values[slot] = value;
+    mark_seen(slot);
+  }
+  pos_args.assign(pos.begin(), pos.end());
+  return true;
+}
+
+void
+CheckArgPrivate::cache_store(const string &path, std::string_view key) const {
+  string record(cache_magic, sizeof(cache_magic));
+  put(record, schema_fingerprint());
+  put_str(record, key);
+
+  uint32_t count = 0;
+  // values from the environment are not, it might be different next time
+  auto cached = [this](uint32_t slot) { return is_seen(slot) && !from_env(slot); };
+  for (uint32_t slot = 0; slot < opts.size(); ++slot) count += cached(slot);
+  put(record, count);
+  for (uint32_t slot = 0; slot < opts.size(); ++slot) {
+    if (!cached(slot)) continue;
+    put(record, slot);
+    put_str(record, values[slot]);
+  }
+  put(record, uint32_t(pos_args.size()));
+  for (auto &arg : pos_args) put_str(record, arg);
+
+  // write it next to its place and rename it there,
+  // so others running at the same time never read half a record.
+  // It holds argv, so only we may read it, and the directory may be shared,
+  // so never follow or reuse what someone else put at that name
+  string tmp = path + '.' + std::to_string(std::random_device{}());
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (fd < 0) return;
+  std::string_view rest = record;
+  while (!rest.empty()) {
+    ssize_t written = ::write(fd, rest.data(), rest.size());
+    if (written < 0 && errno == EINTR) continue;
+    if (written <= 0) break;
+    rest.remove_prefix(written);
+  }
+  if (::close(fd) != 0 || !rest.empty()) {
+    ::unlink(tmp.c_str());
+    return;
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) ::unlink(tmp.c_str());
+}
+
+template<typename GetArg>
 int
-CheckArgPrivate::call_cb(const string &arg) {
-  auto cbpos = valid_args.find(arg);
-  if (cbpos != valid_args.end() && cbpos->second.cb) {
-    int cbret = cbpos->second.cb(parent, arg, cbpos->second.value);
+CheckArgPrivate::parse_cached(int argc, GetArg get) {
+  string key;
+  for (int i = 0; i < argc; ++i) put_str(key, get(i));
+  string path = cache_path(key);
+
+  int ret = parent->parse_begin(get(0));
+  if (ret == CA_ALLOK && cache_load(path, key)) return parent->parse_end(ret);
+
+  // start with 1 here, because argv[0] is special
+  for (int i = 1; ret == CA_ALLOK && i < argc; ++i) { ret = parent->parse_arg(get(i), i); }
+  ret = parent->parse_end(ret);
+  if (ret == CA_ALLOK) cache_store(path, key);
+  return ret;
+}
+
+int
+CheckArgPrivate::call_cb(uint32_t slot) {
+  if (opts[slot].has_cb) {
+    if (limits.max_callbacks && ++cb_count > limits.max_callbacks) {
+      return ca_error(
+        {.code = CA_LIMIT, .index = cur_index, .detail = "too many callbacks"});
+    }
+    auto &cb = callbacks[slot];
+    CA_PROBE(callback__entry, cb.name.c_str());
+    int cbret = cb.fn(parent, cb.name, values[slot]);
+    CA_PROBE(callback__return, cb.name.c_str(), cbret);
     if (cbret != CA_ALLOK) {
       // if callback returns anything other than CA_ALLOK, there's been an error
-      return ca_error(CA_CALLBACK, ": %d!", cbret);
+      return ca_error({
+        .code    = CA_CALLBACK,
+        .index   = cur_index,
+        .option  = names[slot],
+        .cb_code = cbret,
+      });
     }
   }
   return CA_ALLOK;
 }
 
+void
+checkarg::FlatMap::clear() {
+  items.clear();
+  // all buckets become empty by starting a new generation
+  if (++generation == 0) {
+    std::fill(buckets.begin(), buckets.end(), Bucket{});
+    generation = 1;
+  }
+}
+
+void
+checkarg::FlatMap::own(std::string &text) {
+  size_t size = 0;
+  for (auto &[key, value] : items) size += key.size() + value.size();
+  text.resize(size);  // keeps the capacity, so a reparse doesn't allocate
+  char *out = text.data();
+  for (auto &[key, value] : items) {
+    // the contents stay the same, so the buckets do, too
+    std::copy(key.begin(), key.end(), out);
+    key = {out, key.size()};
+    out += key.size();
+    std::copy(value.begin(), value.end(), out);
+    value = {out, value.size()};
+    out += value.size();
+  }
+}
+
+void
+checkarg::FlatMap::set(std::string_view key, std::string_view value) {
+  if (2 * (items.size() + 1) > buckets.size()) grow();
+
+  auto &bucket = buckets[bucket_of(key)];
+  if (bucket.generation == generation) {
+    items[bucket.item].second = value;
+    return;
+  }
+  bucket = {.generation = generation, .item = uint32_t(items.size())};
+  items.emplace_back(key, value);
+}
+
+const checkarg::FlatMap::Entry *
+checkarg::FlatMap::find(std::string_view key) const {
+  if (items.empty()) return nullptr;
+  auto &bucket = buckets[bucket_of(key)];
+  return bucket.generation == generation ? &items[bucket.item] : nullptr;
+}
+
+size_t
+checkarg::FlatMap::bucket_of(std::string_view key) const {
+  // linear probing, there is always an empty bucket, as at most half are used
+  size_t mask = buckets.size() - 1;
+  for (size_t i = std::hash<std::string_view>{}(key) & mask;; i = (i + 1) & mask) {
+    auto &bucket = buckets[i];
+    if (bucket.generation != generation || items[bucket.item].first == key) return i;
+  }
+}
+
+void
+checkarg::FlatMap::grow() {
+  buckets.assign(std::max<size_t>(16, 2 * buckets.size()), Bucket{});
+  for (uint32_t i = 0; i < items.size(); ++i) {
+    buckets[bucket_of(items[i].first)] = {.generation = generation, .item = i};
+  }
+}
+
 int
-checkarg::show_autohelp(CheckArg *const ca, const string &, const string &val) {
+checkarg::show_autohelp(CheckArg *const ca, const string &, const string &) {
   ca->show_help();
   exit(0);  // always exit after showing help
 }
 
 string
-checkarg::str_to_upper(const string &src) {
-  auto &f = std::use_facet<std::ctype<char>>(std::locale());
-  string result;
-  result.reserve(src.size());
-  std::transform(
-    src.begin(), src.end(), std::back_inserter(result),
-    [&](string::value_type c) -> string::value_type { return f.toupper(c); });
+checkarg::str_to_upper(std::string_view src) {
+  string result(src.size(), '\0');
+  str_to_upper(src, result.data());
   return result;
 }
 
+void
+checkarg::str_to_upper(std::string_view src, char *dst) {
+  for (char c : src) *dst++ = (c >= 'a' && c <= 'z') ? c - ('a' - 'A') : c;
+}
 
-#if CA_PRINTERR
-#if not HAS_VASPRINTF
+#ifdef CA_X86_SIMD
+namespace {
 
-#include <cstring>
-int
-vasprintf(char **strp, const char *format, va_list ap) {
-  int count;
-  // Find out how long the resulting string is
-  count = _vscprintf(format, ap);
-  if (count == 0) {
-    *strp = strdup("");
-    return *strp == NULL ? -1 : 0;
+__attribute__((target("avx2"))) size_t
+find_char_avx2(std::string_view str, char c) {
+  const char *data = str.data();
+  size_t size      = str.size();
+  __m256i needle   = _mm256_set1_epi8(c);
+
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+    if (mask) return i + __builtin_ctz(mask);
   }
-  else if (count < 0) {
-    // Something went wrong, so return the error code (probably still requires checking
-    // of "errno" though)
-    return count;
+  for (; i < size; ++i)
+    if (data[i] == c) return i;
+  return std::string_view::npos;
+}
+
+size_t
+find_char_sse2(std::string_view str, char c) {
+  const char *data = str.data();
+  size_t size      = str.size();
+  __m128i needle   = _mm_set1_epi8(c);
+
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    if (mask) return i + __builtin_ctz(mask);
+  }
+  for (; i < size; ++i)
+    if (data[i] == c) return i;
+  return std::string_view::npos;
+}
+
+__attribute__((target("avx2"))) void
+split_char_avx2(std::string_view str, char c, vector<std::string_view> &out) {
+  const char *data = str.data();
+  size_t size      = str.size();
+  __m256i needle   = _mm256_set1_epi8(c);
+
+  size_t start = 0;
+  size_t i     = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+    unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+    // one item ends at each bit set
+    for (; mask; mask &= mask - 1) {
+      size_t end = i + __builtin_ctz(mask);
+      out.emplace_back(data + start, end - start);
+      start = end + 1;
+    }
   }
-  // Allocate memory for our string
-  *strp = (char *)malloc(count + 1);
-  if (*strp == NULL) {
-    abort();
-    return -1;
+  for (; i < size; ++i) {
+    if (data[i] != c) continue;
+    out.emplace_back(data + start, i - start);
+    start = i + 1;
   }
-  // Do the actual printing into our newly created string
-  return vsprintf(*strp, format, ap);
+  out.emplace_back(data + start, size - start);
 }
 
+void
+split_char_sse2(std::string_view str, char c, vector<std::string_view> &out) {
+  const char *data = str.data();
+  size_t size      = str.size();
+  __m128i needle   = _mm_set1_epi8(c);
+
+  size_t start = 0;
+  size_t i     = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+    for (; mask; mask &= mask - 1) {
+      size_t end = i + __builtin_ctz(mask);
+      out.emplace_back(data + start, end - start);
+      start = end + 1;
+    }
+  }
+  for (; i < size; ++i) {
+    if (data[i] != c) continue;
+    out.emplace_back(data + start, i - start);
+    start = i + 1;
+  }
+  out.emplace_back(data + start, size - start);
+}
+
+}  // namespace
 #endif
+
+size_t
+checkarg::find_char(std::string_view str, char c) {
+#ifdef CA_X86_SIMD
+  // SSE2 is part of x86-64, AVX2 is not
+  if (__builtin_cpu_supports("avx2")) return find_char_avx2(str, c);
+  return find_char_sse2(str, c);
+#else
+  return str.find(c);
 #endif
+}
+
+void
+checkarg::split_char(std::string_view str, char c, vector<std::string_view> &out) {
+#ifdef CA_X86_SIMD
+  if (__builtin_cpu_supports("avx2")) return split_char_avx2(str, c, out);
+  return split_char_sse2(str, c, out);
+#else
+  for (size_t end; (end = str.find(c)) != std::string_view::npos;) {
+    out.push_back(str.substr(0, end));
+    str.remove_prefix(end + 1);
+  }
+  out.push_back(str);
+#endif
+}
@@ -4,10 +4,19 @@
 #ifndef CHECKARG_HPP
 #define CHECKARG_HPP
 
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <concepts>
 #include <functional>
+#include <iterator>
 #include <map>
 #include <memory>  // shared_ptr
+#include <ranges>
+#include <span>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 
@@ -16,9 +25,31 @@ class CheckArg;
 
 namespace checkarg {
 class CheckArgPrivate;
+class ConfigSource;
 
 // autohelp callback
 int show_autohelp(CheckArg *const, const std::string &, const std::string &);
+
+/**
+ * \brief details about the error the last CheckArg::parse() failed with
+ *
+ * Filling this in never allocates, `option` is a view into the argv
+ * given to parse(), so it is only valid as long as that argv is.
+ */
+struct ParseError {
+  int code      = 0;   ///< a code from CAError, CA_ALLOK if there was no error
+  int index     = -1;  ///< argv index of the offending argument, -1 if none
+  size_t offset = 0;   ///< byte offset of `option` inside argv[index]
+  std::string_view option{};  ///< offending option without leading dashes
+  bool is_short      = false;    ///< whether `option` is a short option
+  int cb_code        = 0;        ///< return code of the callback for CA_CALLBACK
+  const char *detail = nullptr;  ///< static detail message if there is no option
+  std::string_view suggestion{};  ///< a known long option close to an unknown `option`
+  int rule = -1;  ///< index of the constraint failing with CA_CONSTRAINT
+};
+
+// formats a ParseError like the message printed on stderr
+std::string format_error(const ParseError &err);
 };  // namespace checkarg
 
 // return codes
@@ -29,14 +60,194 @@ enum CAError {
   CA_INVVAL,
   CA_MISSVAL,
   CA_CALLBACK,
+  CA_BADVAL,
+  CA_LIMIT,
+  CA_INVFEATURE,
+  CA_CONSTRAINT,
+  CA_PATH,
 };
 
 enum CAValueType {
   CA_VT_NONE = 0,
   CA_VT_REQUIRED,
   // CA_VT_OPTIONAL,
+  CA_VT_DICT,  // like -Dkey=value, any number of times, see value(lopt, key)
+  CA_VT_LIST,  // like --tags=a,b,c, any number of times, see values(lopt)
+  CA_VT_FILE,  // like --dict=@words.txt, the file is mapped by file(lopt, contents)
+};
+
+namespace checkarg {
+// what a path argument has to be, see CheckArg::set_path_check()
+enum PathCheck : uint8_t {
+  PC_EXISTS   = 1,
+  PC_FILE     = 2,  // a regular file, or with PC_DIR either of them
+  PC_DIR      = 4,
+  PC_READABLE = 8,
+};
+
+/**
+ * \brief bounds on the work a single parse() may do, 0 means unlimited
+ *
+ * A parse exceeding one of these fails with CA_LIMIT as soon as it does.
+ */
+struct Limits {
+  size_t max_args        = 0;  ///< number of arguments, including argv[0]
+  size_t max_arg_length  = 0;  ///< length of a single argument in bytes
+  size_t max_total_bytes = 0;  ///< length of all arguments together
+  size_t max_callbacks   = 0;  ///< number of callbacks called
+  std::chrono::nanoseconds max_time{0};  ///< time spent inside parse()
+};
+
+/**
+ * \brief an option for CheckArg::add_all()
+ *
+ * The strings are borrowed, not copied, so they must outlive the CheckArg.
+ * A constexpr array of these using string literals is the intended use.
+ */
+struct OptSpec {
+  char sopt = 0;
+  std::string_view lopt{};
+  std::string_view help{};
+  CAValueType value_type = CA_VT_NONE;
+  std::string_view value_name{};  // generated from lopt, if empty for value options
+  int (*cb)(CheckArg *const, const std::string &, const std::string &) = nullptr;
+  char delimiter = ',';  // for CA_VT_LIST options
+  std::string_view default_value{};  // for single value options, none if null
+};
+
+/**
+ * \brief the value of an option, kept up to date by CheckArg::bind()
+ *
+ * Reading a flag never locks, so it can be done from hot loops,
+ * flags bound as mutable can also be changed at runtime by an AdminServer.
+ */
+class FlagBase {
+public:
+  virtual ~FlagBase() = default;
+
+  // whether text can be stored
+  virtual bool check(std::string_view text) const = 0;
+  // store text as the new value, false if it's invalid
+  virtual bool store(std::string_view text)       = 0;
+  virtual void store_default()                    = 0;
+  virtual std::string text() const                = 0;
+
+  std::string_view name() const { return flag_name; }
+  bool is_mutable() const { return runtime_mutable; }
+
+private:
+  friend class ::CheckArg;
+  std::string_view flag_name;
+  bool runtime_mutable = false;
 };
 
+/**
+ * \brief a flag holding a number or a bool in an atomic
+ *
+ * A non-value option stores 1 or true when given.
+ */
+template<typename T>
+class Flag final : public FlagBase {
+  static_assert(std::is_arithmetic_v<T>);
+
+public:
+  explicit Flag(T def = T{}) : def(def), val(def) {}
+
+  T get() const { return val.load(std::memory_order_relaxed); }
+  operator T() const { return get(); }
+
+  bool check(std::string_view text) const override {
+    T tmp;
+    return convert(text, tmp);
+  }
+  bool store(std::string_view text) override {
+    T tmp;
+    if (!convert(text, tmp)) return false;
+    val.store(tmp, std::memory_order_relaxed);
+    return true;
+  }
+  void store_default() override { val.store(def, std::memory_order_relaxed); }
+  std::string text() const override {
+    if constexpr (std::is_same_v<T, bool>) { return get() ? "true" : "false"; }
+    else {
+      char buf[64];
+      auto res = std::to_chars(buf, buf + sizeof(buf), get());
+      return std::string(buf, res.ptr);
+    }
+  }
+
+private:
+  static bool convert(std::string_view text, T &out) {
+    if constexpr (std::is_same_v<T, bool>) {
+      out = text == "1" || text == "true" || text == "yes" || text == "on";
+      return out || text == "0" || text == "false" || text == "no" || text == "off";
+    }
+    else {
+      auto end = text.data() + text.size();
+      auto res = std::from_chars(text.data(), end, out);
+      return res.ec == std::errc() && res.ptr == end;
+    }
+  }
+
+  const T def;
+  std::atomic<T> val;
+};
+
+/**
+ * \brief a flag holding a string
+ *
+ * Every new value is published as a new immutable snapshot,
+ * a reader keeps the one it got alive for as long as it needs.
+ */
+template<>
+class Flag<std::string> final : public FlagBase {
+public:
+  explicit Flag(std::string def = {})
+    : def(std::make_shared<const std::string>(std::move(def))), val(this->def) {}
+
+  std::shared_ptr<const std::string> get() const {
+    return val.load(std::memory_order_acquire);
+  }
+
+  bool check(std::string_view) const override { return true; }
+  bool store(std::string_view text) override {
+    val.store(std::make_shared<const std::string>(text), std::memory_order_release);
+    return true;
+  }
+  void store_default() override { val.store(def, std::memory_order_release); }
+  std::string text() const override { return *get(); }
+
+private:
+  const std::shared_ptr<const std::string> def;
+  std::atomic<std::shared_ptr<const std::string>> val;
+};
+
+/**
+ * \brief a named feature, see CheckArg::add_feature()
+ *
+ * Checking a feature is a single bit test, so it can be done from hot loops.
+ * It is enabled or disabled by the last successful parse. The bits are read
+ * and written atomically, so a handle may be checked from other threads while
+ * a reparse is running; it sees the feature's old or new state.
+ */
+class FeatureHandle {
+public:
+  FeatureHandle() = default;
+  bool enabled() const {
+    return word && (word->load(std::memory_order_relaxed) >> (index % 64)) & 1;
+  }
+  explicit operator bool() const { return enabled(); }
+  uint32_t id() const { return index; }
+
+private:
+  FeatureHandle(const std::atomic<uint64_t> *word, uint32_t index)
+    : word(word), index(index) {}
+  const std::atomic<uint64_t> *word = nullptr;
+  uint32_t index                    = 0;
+  friend class ::CheckArg;
+};
+}  // namespace checkarg
+
 // the checkarg class
 class CheckArg {
 
@@ -85,12 +296,66 @@ public:
     std::function<int(CheckArg *const, const std::string &, const std::string &)> cb,
     const CAValueType value_type, const std::string &value_name);
 
+  int add_all(std::span<const checkarg::OptSpec> specs);
+
   int add_autohelp();
 
+  // constraints on which options are given, checked after parsing
+  int add_required(const std::string &lopt);
+  int add_conflict(const std::vector<std::string> &lopts);
+  int add_requires(const std::string &lopt, const std::string &required);
+
+  // take the values of options not given from environment variables
+  int bind_env(const std::string &lopt, const std::string &var);
+  void set_env_prefix(const std::string &prefix);
+
+  // what value() returns for an option not given
+  int set_default(const std::string &lopt, const std::string &value);
+
+  // where the values of a CA_VT_LIST option are split, ',' by default
+  int set_delimiter(const std::string &lopt, char delimiter);
+
+  // check that values or positional args are paths, see checkarg::PathCheck
+  int set_path_check(const std::string &lopt, unsigned checks);
+  void set_pos_path_check(unsigned checks);
+
+  // named features, toggled by lists like --enable-features=A,B
+  checkarg::FeatureHandle add_feature(const std::string &name, bool enabled = false);
+  int add_feature_options(
+    const std::string &enable_lopt  = "enable-features",
+    const std::string &disable_lopt = "disable-features");
+  bool enabled(const std::string &feature) const;
+
+  // keep flag up to date with the option's value after every successful parse
+  int bind(
+    const std::string &lopt, checkarg::FlagBase &flag, bool runtime_mutable = false);
+  std::vector<checkarg::FlagBase *> flags() const;
+
   // do parse!
   void reset();
   int parse(const int argc, char **argv);
   int parse(const std::vector<std::string> &argv);
+  // removes known options and their values from argv, passing on the rest
+  int parse_consume(int &argc, char **argv);
+  template<std::ranges::input_range R>
+    requires std::convertible_to<std::ranges::range_reference_t<R>, std::string_view>
+  int parse(R &&argv);
+
+  // parse huge command lines using multiple threads, 0 means one per core
+  void set_parse_threads(unsigned threads);
+
+  // bound the work done by parse() on untrusted input
+  void set_limits(const checkarg::Limits &limits);
+
+  // accept long options that weren't added, see adhoc_options()
+  void set_opportunistic(bool opportunistic);
+
+  // don't collect pos_args() while parsing, use pos_args_range() instead
+  void set_lazy_pos_args(bool lazy);
+
+  // reuse the results of parsing the same argv before, stored in dir,
+  // the records keep the whole argv on disk, readable by the current user only
+  void set_cache_dir(const std::string &dir);
 
   // set some autohelp strings
   void set_posarg_help(const std::string &usage, const std::string &descr);
@@ -100,7 +365,21 @@ public:
   std::string argv0();
   std::string callname();
   std::vector<std::string> pos_args() const;
+  class PosArgRange;
+  PosArgRange pos_args_range() const;
+  std::span<const std::pair<std::string_view, std::string_view>> adhoc_options() const;
   std::string value(const std::string &arg) const;
+  std::string_view value_view(const std::string &arg) const;
+  // the entries of a CA_VT_DICT option
+  std::string value(const std::string &lopt, std::string_view key) const;
+  std::span<const std::pair<std::string_view, std::string_view>>
+  dict(const std::string &lopt) const;
+  // the items of a CA_VT_LIST option
+  std::span<const std::string_view> values(const std::string &lopt) const;
+  // the contents of the file given to a CA_VT_FILE option, mapped when first needed
+  int file(const std::string &lopt, std::span<const char> &contents) const;
+  // replace an option's value, e.g. from a callback normalizing it
+  int set_value(const std::string &lopt, const std::string &value);
   std::string autohelp();
   std::string usage();
 
@@ -111,11 +390,32 @@ public:
   void show_help();
   void show_usage();
 
-  // get error string for errno
-  static std::string str_err(const int errno);
+  // get error string for an error code
+  static std::string str_err(const int eno);
+
+  // details of the error the last parse() returned
+  const checkarg::ParseError &error() const;
+  std::string error_message() const;
+  // every path failing its checks in the last parse, error() is the first of them
+  std::span<const checkarg::ParseError> path_errors() const;
+
+  // print errors to stderr while parsing, defaults to the printerr build option
+  void set_print_errors(bool print);
 
 private:
+  void keep_argv(char *const *ptrs, const std::string *strs, int argc);
+  int empty_argv_error();
+  int parse_begin(std::string_view argv0);
+  int parse_arg(std::string_view arg, int index);
+  int parse_end(int ret);
+  std::string_view copy_arg(std::string_view arg, int index);
+
+  std::string_view argv_at(int index) const;
+  int next_pos_arg(int index, int end, bool &sep) const;
+
   std::unique_ptr<checkarg::CheckArgPrivate> p;
+  friend class checkarg::CheckArgPrivate;
+  friend class checkarg::ConfigSource;
 
   /**
    * \brief function which will be the callback for '-\-help'
@@ -126,5 +426,93 @@ private:
   checkarg::show_autohelp(CheckArg *const, const std::string &, const std::string &);
 };
 
+/**
+ * \brief the positional args of the last parse, found while iterating over its argv
+ * \see CheckArg::pos_args_range()
+ */
+class CheckArg::PosArgRange {
+public:
+  class iterator {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type       = std::string_view;
+    using difference_type  = std::ptrdiff_t;
+
+    iterator() = default;
+
+    std::string_view operator*() const { return ca->argv_at(index); }
+    iterator &operator++() {
+      index = ca->next_pos_arg(index + 1, end, sep);
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+    bool operator==(std::default_sentinel_t) const { return index >= end; }
+
+  private:
+    friend class PosArgRange;
+    const CheckArg *ca = nullptr;
+    int index          = 0;
+    int end            = 0;
+    bool sep           = false;  // a '--' was passed
+  };
+
+  iterator begin() const;
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  friend class CheckArg;
+  explicit PosArgRange(const CheckArg *ca) : ca(ca) {}
+  const CheckArg *ca;
+};
+
+/**
+ * \brief parse the command line from any range of strings
+ *
+ * Elements can be anything convertible to std::string_view, like const char *,
+ * std::string_view or std::string, so argv never needs to be converted.
+ * A range that can only be iterated once is fine, positional args are then
+ * always collected into pos_args().
+ * value() and adhoc_options() are copied, but like with the other overloads,
+ * dict(), values() and error() point into the given range, so the range's
+ * elements must outlive their use.
+ * Elements that don't outlive the iteration, like the strings returned by a
+ * transforming view or those read by std::views::istream, are copied first,
+ * these views then point into the copies, valid until the next parse.
+ * \param argv the arguments, the first one is the name the app was called with
+ * \return CA_ALLOK on success, some other code from CAError otherwise
+ */
+template<std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_reference_t<R>, std::string_view>
+int
+CheckArg::parse(R &&argv) {
+  if constexpr (std::same_as<std::remove_cvref_t<R>, std::vector<std::string>>) {
+    return parse(std::as_const(argv));  // can be iterated lazily or in parallel
+  }
+  else {
+    auto it  = std::ranges::begin(argv);
+    auto end = std::ranges::end(argv);
+    if (it == end) return empty_argv_error();
+
+    using Ref = std::ranges::range_reference_t<R>;
+    // views into the elements are kept, so they must not be temporaries
+    constexpr bool borrowed = std::ranges::forward_range<R> &&
+      (std::is_lvalue_reference_v<Ref> || std::convertible_to<Ref, const char *> ||
+       std::same_as<std::remove_cvref_t<Ref>, std::string_view>);
+    auto arg = [this](Ref elem, int index) -> std::string_view {
+      if constexpr (borrowed) return elem;
+      else return copy_arg(elem, index);
+    };
+
+    keep_argv(nullptr, nullptr, 0);  // it might not be iterable again
+    int ret = parse_begin(arg(*it, 0));
+    // start with 1 here, because argv[0] is special
+    int index = 1;
+    for (++it; ret == CA_ALLOK && it != end; ++it, ++index) {
+      ret = parse_arg(arg(*it, index), index);
+    }
+    return parse_end(ret);
+  }
+}
+
 
 #endif  // CHECKARG_HPP
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2013-2021 brainpower <brainpower at mailbox dot org>
+
+#include "checkargpp_admin.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using checkarg::AdminServer;
+
+using std::string;
+using std::string_view;
+
+namespace {
+
+constexpr size_t max_line = 4096;
+
+bool
+send_all(int fd, string_view data) {
+  while (!data.empty()) {
+    auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) continue;
+    if (sent <= 0) return false;
+    data.remove_prefix(sent);
+  }
+  return true;
+}
+
+// splits off the first word of line
+string_view
+next_word(string_view &line) {
+  auto start = line.find_first_not_of(' ');
+  if (start == string_view::npos) start = line.size();
+  line.remove_prefix(start);
+  auto end  = std::min(line.find(' '), line.size());
+  auto word = line.substr(0, end);
+  line.remove_prefix(end);
+  return word;
+}
+
+}  // namespace
+
+AdminServer::~AdminServer() {
+  stop();
+}
+
+/**
+ * \brief start serving on a unix socket
+ *
+ * An existing socket at path is replaced, anything else there is left alone
+ * and fails with EEXIST. Only the owner may connect to the socket.
+ * \param ca the CheckArg whose bound flags are served, they must outlive the server
+ * \param path where to create the socket
+ * \return CA_ALLOK, or CA_ERROR with errno telling why
+ */
+int
+AdminServer::start(const CheckArg &ca, const string &path) {
+  stop();
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return CA_ERROR;
+  }
+  std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+  struct stat st;
+  if (::lstat(path.c_str(), &st) == 0) {
+    if (!S_ISSOCK(st.st_mode)) {
+      errno = EEXIST;
+      return CA_ERROR;
+    }
+    if (::unlink(path.c_str()) < 0) return CA_ERROR;
+  }
+  else if (errno != ENOENT) return CA_ERROR;
+
+  listen_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) return CA_ERROR;
+  if (::bind(listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0) {
+    int err = errno;
+    stop();
+    errno = err;
+    return CA_ERROR;
+  }
+  this->path = path;  // ours now, stop() removes it
+
+  // nobody can connect before listen(), so there is no window with other modes
+  if (
+    ::chmod(path.c_str(), 0600) < 0 || ::listen(listen_fd, 4) < 0
+    || ::pipe2(wakeup, O_CLOEXEC) < 0) {
+    int err = errno;
+    stop();
+    errno = err;
+    return CA_ERROR;
+  }
+
+  flags      = ca.flags();
+  thread     = std::thread(&AdminServer::run, this);
+  return CA_ALLOK;
+}
+
+/**
+ * \brief set how long a client may take to send a command
+ *
+ * Clients are served one after another, one that doesn't finish its line
+ * in time is disconnected, so it can't keep the others waiting.
+ * \param ms the timeout in milliseconds, 5000 by default
+ */
+void
+AdminServer::set_client_timeout(int ms) {
+  client_timeout = ms;
+}
+
+/**
+ * \brief stop serving and remove the socket
+ */
+void
+AdminServer::stop() {
+  if (thread.joinable()) {
+    char c = 0;
+    while (::write(wakeup[1], &c, 1) < 0 && errno == EINTR) {}
+    thread.join();
+  }
+  for (int *fd : {&listen_fd, &wakeup[0], &wakeup[1]}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+  if (!path.empty()) ::unlink(path.c_str());
+  path.clear();
+}
+
+void
+AdminServer::run() {
+  pollfd fds[2] = {
+    {.fd = wakeup[0], .events = POLLIN, .revents = 0},
+    {.fd = listen_fd, .events = POLLIN, .revents = 0},
+  };
+  for (;;) {
+    if (::poll(fds, 2, -1) < 0 && errno != EINTR) return;
+    if (fds[0].revents) return;
+    if (fds[1].revents & POLLIN) {
+      int client = ::accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+      if (client < 0) continue;
+      serve(client);
+      ::close(client);
+    }
+  }
+}
+
+void
+AdminServer::serve(int client) {
+  pollfd fds[2] = {
+    {.fd = wakeup[0], .events = POLLIN, .revents = 0},
+    {.fd = client, .events = POLLIN, .revents = 0},
+  };
+  using clock  = std::chrono::steady_clock;
+  auto timeout  = std::chrono::milliseconds(client_timeout);
+  auto deadline = clock::now() + timeout;
+  string buffer;
+  char chunk[512];
+  for (;;) {
+    auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - clock::now());
+    if (left.count() <= 0) return;
+    int ready = ::poll(fds, 2, int(left.count()));
+    if (ready < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    if (ready == 0) return;      // too slow, let the next one in
+    if (fds[0].revents) return;  // leave the wakeup for run()
+
+    auto got = ::read(client, chunk, sizeof(chunk));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) return;
+    buffer.append(chunk, got);
+
+    size_t eol;
+    while ((eol = buffer.find('\n')) != string::npos) {
+      string_view line(buffer.data(), eol);
+      if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+      if (!send_all(client, command(line))) return;
+      buffer.erase(0, eol + 1);
+      deadline = clock::now() + timeout;
+    }
+    if (buffer.size() > max_line) {
+      send_all(client, "error: line too long\n");
+      return;
+    }
+  }
+}
+
+std::string
+AdminServer::command(string_view line) {
+  auto cmd  = next_word(line);
+  auto name = next_word(line);
+  auto find = [this](string_view name) -> FlagBase * {
+    for (auto flag : flags)
+      if (flag->name() == name) return flag;
+    return nullptr;
+  };
+
+  if (cmd == "list" && name.empty()) {
+    string result;
+    for (auto flag : flags) {
+      result.append(flag->name()).append("=").append(flag->text());
+      result.append(flag->is_mutable() ? " rw\n" : " ro\n");
+    }
+    return result + "ok\n";
+  }
+  if (cmd == "get" && !name.empty()) {
+    auto flag = find(name);
+    if (!flag) return "error: unknown flag\n";
+    return string(name) + "=" + flag->text() + "\nok\n";
+  }
+  if (cmd == "set" && !name.empty()) {
+    // the value is the rest of the line, after one space
+    if (!line.empty()) line.remove_prefix(1);
+    auto flag = find(name);
+    if (!flag) return "error: unknown flag\n";
+    if (!flag->is_mutable()) return "error: flag is read-only\n";
+    if (!flag->store(line)) return "error: invalid value\n";
+    return "ok\n";
+  }
+  return "error: unknown command\n";
+}
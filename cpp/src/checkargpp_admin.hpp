@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2013-2021 brainpower <brainpower at mailbox dot org>
+
+#ifndef CHECKARG_ADMIN_HPP
+#define CHECKARG_ADMIN_HPP
+
+#include "checkargpp.hpp"
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace checkarg {
+
+/**
+ * \brief serves the flags bound to a CheckArg on a local unix socket
+ *
+ * Every command is a line, every answer ends with a line "ok" or "error: why".
+ *  - `list` answers with a line `name=value rw` or `name=value ro` per flag
+ *  - `get name` answers with a line `name=value`
+ *  - `set name value` changes a flag bound as runtime mutable
+ *
+ * Clients are served one after another, by a thread of its own,
+ * each one has to send a whole line within the client timeout.
+ */
+class AdminServer {
+public:
+  AdminServer() = default;
+  ~AdminServer();
+
+  AdminServer(const AdminServer &)            = delete;
+  AdminServer &operator=(const AdminServer &) = delete;
+
+  // serve the flags bound to ca, bind them before calling this
+  int start(const CheckArg &ca, const std::string &path);
+  void set_client_timeout(int ms);
+  void stop();
+
+private:
+  void run();
+  void serve(int client);
+  std::string command(std::string_view line);
+
+  std::vector<FlagBase *> flags;
+  std::string path;
+  std::atomic<int> client_timeout = 5000;  // ms
+  int listen_fd                    = -1;
+  int wakeup[2]                    = {-1, -1};  // written to by stop()
+  std::thread thread;
+};
+
+}  // namespace checkarg
+
+#endif  // CHECKARG_ADMIN_HPP
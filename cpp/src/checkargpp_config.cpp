@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2013-2021 brainpower <brainpower at mailbox dot org>
+
+#include "checkargpp_config.hpp"
+#include "checkargpp_private.hpp"
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+using checkarg::ConfigSnapshot;
+using checkarg::ConfigSource;
+
+using std::string;
+using std::string_view;
+
+namespace {
+
+constexpr string_view blanks = " \t\r\n";
+
+bool
+read_file(const string &path, string &out) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  out.clear();
+  char chunk[4096];
+  for (;;) {
+    auto got = ::read(fd, chunk, sizeof(chunk));
+    if (got < 0 && errno == EINTR) continue;
+    if (got <= 0) {
+      int err = errno;
+      ::close(fd);
+      errno = err;
+      return got == 0;
+    }
+    out.append(chunk, got);
+  }
+}
+
+// [begin, end) of str without surrounding blanks
+std::pair<size_t, size_t>
+trim(string_view str, size_t begin, size_t end) {
+  while (begin < end && blanks.find(str[begin]) != string_view::npos) ++begin;
+  while (end > begin && blanks.find(str[end - 1]) != string_view::npos) --end;
+  return {begin, end};
+}
+
+// copies error and the text its option may point into
+void
+copy_error(
+  const checkarg::ParseError &error, const string &text, checkarg::ParseError &to,
+  string &to_text) {
+  to_text = text;
+  to      = error;
+  auto at = error.option.data();
+  if (at >= text.data() && at < text.data() + text.size())
+    to.option = string_view(to_text).substr(at - text.data(), error.option.size());
+}
+
+// calls changed(name, value, removed) for every option whose value differs
+template<typename Changed>
+void
+diff(const ConfigSnapshot &from, const ConfigSnapshot &to, Changed changed) {
+  auto old_it = from.entries().begin(), new_it = to.entries().begin();
+  while (old_it != from.entries().end() || new_it != to.entries().end()) {
+    if (new_it == to.entries().end()
+        || (old_it != from.entries().end() && old_it->first < new_it->first)) {
+      changed(old_it->first, string_view(), true);
+      ++old_it;
+    }
+    else if (old_it == from.entries().end() || new_it->first < old_it->first) {
+      changed(new_it->first, new_it->second, false);
+      ++new_it;
+    }
+    else {
+      if (old_it->second != new_it->second)
+        changed(new_it->first, new_it->second, false);
+      ++old_it, ++new_it;
+    }
+  }
+}
+
+}  // namespace
+
+/**
+ * \brief get the value an option is set to by the file
+ * \return the value, a null view if it is not set
+ */
+string_view
+ConfigSnapshot::value(string_view lopt) const {
+  auto entry = find(lopt);
+  return entry ? entry->second : string_view();
+}
+
+/**
+ * \brief check whether the file sets an option
+ */
+bool
+ConfigSnapshot::isset(string_view lopt) const {
+  return find(lopt);
+}
+
+const ConfigSnapshot::Entry *
+ConfigSnapshot::find(string_view lopt) const {
+  auto pos = std::lower_bound(
+    sorted.begin(), sorted.end(), lopt,
+    [](const Entry &entry, string_view name) { return entry.first < name; });
+  if (pos != sorted.end() && pos->first == lopt) return &*pos;
+  return nullptr;
+}
+
+ConfigSource::~ConfigSource() {
+  stop();
+}
+
+/**
+ * \brief apply a config file to a parsed CheckArg and watch it for changes
+ *
+ * Options given on the command line or by the environment keep their bound flags,
+ * their callbacks are still called.
+ * The options and flags ca has now are the ones the file can set,
+ * start() again after adding or binding more.
+ * \param ca the CheckArg, parsed already, it must outlive the source
+ * \param path the config file, the directory it is in is watched
+ * \return CA_ALLOK, CA_ERROR with errno telling why,
+ * or the error the file has, see error()
+ */
+int
+ConfigSource::start(CheckArg &ca, const string &path) {
+  stop();
+  this->ca   = &ca;
+  this->path = path;
+  current.store(nullptr);
+  delivered.reset();
+
+  // the watcher must not touch ca, what it needs is copied here
+  auto &p = *ca.p;
+  options.clear();
+  for (uint32_t slot = 0; slot < p.names.size(); ++slot) {
+    if (p.names[slot].empty()) continue;
+    options.push_back({
+      .name      = string(p.names[slot]),
+      .slot      = slot,
+      .has_value = p.opts[slot].value_type != CA_VT_NONE,
+    });
+  }
+  std::sort(options.begin(), options.end(), [](const Option &a, const Option &b) {
+    return a.name < b.name;
+  });
+  bound.clear();
+  for (auto [slot, flag] : p.flags) {
+    auto text = p.is_seen(slot) && !p.opts[slot].value_type ? "1" : p.value_of(slot);
+    bound.push_back({
+      .slot     = slot,
+      .flag     = flag,
+      .given    = p.is_seen(slot),
+      .has_base = text.data() != nullptr,
+      .base     = string(text),
+    });
+  }
+
+  int ret = reload();
+  if (ret != CA_ALLOK) return ret;
+
+  auto slash = path.rfind('/');
+  auto dir   = slash == string::npos ? string(".") : path.substr(0, slash + 1);
+  inotify_fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+  if (
+    inotify_fd < 0
+    || ::inotify_add_watch(inotify_fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0
+    || ::pipe2(wakeup, O_CLOEXEC) < 0) {
+    int err = errno;
+    stop();
+    errno = err;
+    return CA_ERROR;
+  }
+  thread = std::thread(&ConfigSource::run, this);
+  return CA_ALLOK;
+}
+
+/**
+ * \brief stop watching the file
+ *
+ * The last snapshot stays readable, changes it has not delivered yet
+ * are left for poll().
+ */
+void
+ConfigSource::stop() {
+  if (thread.joinable()) {
+    char c = 0;
+    while (::write(wakeup[1], &c, 1) < 0 && errno == EINTR) {}
+    thread.join();
+  }
+  for (int *fd : {&inotify_fd, &wakeup[0], &wakeup[1]}) {
+    if (*fd >= 0) ::close(*fd);
+    *fd = -1;
+  }
+}
+
+void
+ConfigSource::run() {
+  auto name = string_view(path).substr(path.rfind('/') + 1);
+  pollfd fds[2] = {
+    {.fd = wakeup[0], .events = POLLIN, .revents = 0},
+    {.fd = inotify_fd, .events = POLLIN, .revents = 0},
+  };
+  alignas(inotify_event) char events[4096];
+  for (;;) {
+    if (::poll(fds, 2, -1) < 0 && errno != EINTR) return;
+    if (fds[0].revents) return;
+    if (!(fds[1].revents & POLLIN)) continue;
+
+    bool changed = false;
+    ssize_t got;
+    while ((got = ::read(inotify_fd, events, sizeof(events))) > 0) {
+      for (char *pos = events; pos < events + got;) {
+        auto event = reinterpret_cast<inotify_event *>(pos);
+        if (event->len && string_view(event->name) == name) changed = true;
+        pos += sizeof(inotify_event) + event->len;
+      }
+    }
+    if (changed) update();
+  }
+}
+
+/**
+ * \brief read the file again and apply what changed
+ *
+ * Only the lines between the unchanged start and end of the file are tokenized,
+ * the others are taken over from the last snapshot.
+ * Nothing is applied if the file has an error.
+ * Then calls the callbacks like poll().
+ * \return CA_ALLOK, CA_ERROR if it could not be read,
+ * CA_INVOPT, CA_MISSVAL, CA_INVVAL or CA_BADVAL if it has an error,
+ * or CA_CALLBACK if a callback failed, see error()
+ */
+int
+ConfigSource::reload() {
+  update();
+  return poll();
+}
+
+/**
+ * \brief call the callbacks of the options the file changed since the last poll()
+ *
+ * The watcher only publishes snapshots and updates bound flags,
+ * callbacks are called here, on the thread that owns the CheckArg.
+ * Call it where parse() would be safe to call, e.g. in the event loop.
+ * \return CA_ALLOK, the error of the last reload, or CA_CALLBACK
+ * if a callback failed, see error()
+ */
+int
+ConfigSource::poll() {
+  int eno;
+  {
+    std::lock_guard lock(reloading);
+    copy_error(next_err, next_err_text, err, err_text);
+    eno = next_errno;
+  }
+
+  auto now = snapshot();
+  if (now && now != delivered) {
+    static const ConfigSnapshot empty;
+    auto &p = *ca->p;
+    diff(delivered ? *delivered : empty, *now, [&](auto name, auto value, bool removed) {
+      auto slot = p.find(name);
+      if (slot == no_slot || !p.opts[slot].has_cb) return;
+      auto &cb  = p.callbacks[slot];
+      int cbret = cb.fn(ca, cb.name, removed ? string() : string(value));
+      if (cbret != CA_ALLOK && !err.code) {
+        err = {.code = CA_CALLBACK, .option = p.names[slot], .cb_code = cbret};
+      }
+    });
+    delivered = std::move(now);
+  }
+  if (err.code == CA_ERROR) errno = eno;
+  return err.code;
+}
+
+const ConfigSource::Option *
+ConfigSource::option(string_view name) const {
+  auto pos = std::lower_bound(
+    options.begin(), options.end(), name,
+    [](const Option &option, string_view name) { return option.name < name; });
+  if (pos != options.end() && pos->name == name) return &*pos;
+  return nullptr;
+}
+
+// reads the file and publishes what changed, called by the watcher too,
+// so it only uses what start() copied
+void
+ConfigSource::update() {
+  std::lock_guard lock(reloading);
+  next_err = {};
+
+  auto next = std::make_shared<ConfigSnapshot>();
+  if (!read_file(path, next->text)) return fail({.code = CA_ERROR}, {});
+
+  auto last = current.load(std::memory_order_acquire);
+  static const ConfigSnapshot empty;
+  const auto &prev = last ? *last : empty;
+  if (last && prev.text == next->text) return;
+
+  const string_view old_text = prev.text, text = next->text;
+  if (text.size() > UINT32_MAX) return fail({.code = CA_ERROR}, {});
+
+  // unchanged lines at the start
+  size_t common = std::min(old_text.size(), text.size());
+  auto old_end  = old_text.begin() + common;
+  size_t prefix = std::mismatch(old_text.begin(), old_end, text.begin()).first
+                  - old_text.begin();
+  prefix = prefix ? text.rfind('\n', prefix - 1) + 1 : 0;  // npos + 1 is 0
+
+  // unchanged lines at the end, starting after a newline both have in common
+  size_t suffix = 0;
+  while (suffix < common - prefix
+         && old_text[old_text.size() - 1 - suffix] == text[text.size() - 1 - suffix])
+    ++suffix;
+  size_t middle_end = text.size();
+  if (suffix) {
+    auto eol   = text.find('\n', text.size() - suffix);
+    middle_end = eol == string_view::npos ? text.size() : eol + 1;
+  }
+  size_t old_middle_end = middle_end - text.size() + old_text.size();
+
+  auto &lines = next->lines;
+  for (auto &line : prev.lines) {
+    if (line.end > prefix) break;
+    lines.push_back(line);
+  }
+
+  for (size_t begin = prefix; begin < middle_end;) {
+    size_t eol = text.find('\n', begin);
+    size_t end = eol == string_view::npos ? text.size() : eol + 1;
+    ConfigSnapshot::Line line{.begin = uint32_t(begin), .end = uint32_t(end)};
+    ++next->tokenized;
+
+    auto [key, key_end] = trim(text, begin, end);
+    if (key < key_end && text[key] != '#') {
+      auto eq        = text.substr(0, key_end).find('=', key);
+      bool has_value = eq != string_view::npos;
+      auto [val, val_end] = has_value ? trim(text, eq + 1, key_end)
+                                      : std::pair<size_t, size_t>{key_end, key_end};
+      if (has_value) key_end = trim(text, key, eq).second;
+
+      ParseError error{
+        .index  = int(lines.size() + 1),
+        .offset = key - begin,
+        .option = text.substr(key, key_end - key),
+      };
+      auto opt = option(error.option);
+      if (!opt) {
+        error.code = CA_INVOPT;
+        return fail(error, next->text);
+      }
+      if (opt->has_value && !has_value) error.code = CA_MISSVAL;
+      if (!opt->has_value && has_value) error.code = CA_INVVAL;
+      if (error.code) return fail(error, next->text);
+
+      line.key       = uint32_t(key);
+      line.key_len   = uint32_t(key_end - key);
+      line.value     = uint32_t(val);
+      line.value_len = uint32_t(val_end - val);
+      line.is_entry  = true;
+      line.has_value = has_value;
+    }
+    lines.push_back(line);
+    begin = end;
+  }
+
+  // the lines after the change only moved
+  uint32_t shift = uint32_t(text.size() - old_text.size());  // wraps if it shrank
+  for (auto &line : prev.lines) {
+    if (line.begin < old_middle_end) continue;
+    auto &moved = lines.emplace_back(line);
+    for (auto *offset : {&moved.begin, &moved.end, &moved.key, &moved.value})
+      *offset += shift;
+  }
+
+  for (auto &line : lines) {
+    if (!line.is_entry) continue;
+    next->sorted.emplace_back(
+      text.substr(line.key, line.key_len), text.substr(line.value, line.value_len));
+  }
+  std::stable_sort(
+    next->sorted.begin(), next->sorted.end(),
+    [](const auto &a, const auto &b) { return a.first < b.first; });
+  // of options set more than once, the last one stays
+  auto out = next->sorted.begin();
+  for (auto it = next->sorted.begin(); it != next->sorted.end(); ++it) {
+    if (out != next->sorted.begin() && (out - 1)->first == it->first) *(out - 1) = *it;
+    else *out++ = *it;
+  }
+  next->sorted.erase(out, next->sorted.end());
+
+  // check the flags first, so a bad value does not leave some of them updated
+  for (auto &[name, value] : next->sorted) {
+    auto opt = option(name);
+    for (auto &b : bound) {
+      if (b.slot != opt->slot || b.given || !opt->has_value) continue;
+      if (!b.flag->check(value))
+        return fail({.code = CA_BADVAL, .option = opt->name}, next->text);
+    }
+  }
+
+  next->number = prev.number + 1;
+  current.store(next, std::memory_order_release);
+
+  // flags are atomic, so they are updated right away
+  diff(prev, *next, [&](string_view name, string_view value, bool removed) {
+    auto opt = option(name);
+    for (auto &b : bound) {
+      if (b.slot != opt->slot || b.given) continue;
+      if (!removed) b.flag->store(opt->has_value ? value : "1");
+      else if (b.has_base) b.flag->store(b.base);
+      else b.flag->store_default();
+    }
+  });
+}
+
+void
+ConfigSource::fail(const ParseError &error, const string &text) {
+  next_errno = errno;
+  copy_error(error, text, next_err, next_err_text);
+}
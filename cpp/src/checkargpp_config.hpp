@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2013-2021 brainpower <brainpower at mailbox dot org>
+
+#ifndef CHECKARG_CONFIG_HPP
+#define CHECKARG_CONFIG_HPP
+
+#include "checkargpp.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace checkarg {
+
+/**
+ * \brief the options set by a config file, immutable once published
+ * \see ConfigSource
+ */
+class ConfigSnapshot {
+public:
+  using Entry = std::pair<std::string_view, std::string_view>;
+
+  std::string_view value(std::string_view lopt) const;
+  bool isset(std::string_view lopt) const;
+  // sorted by name, an option set twice has its last value
+  std::span<const Entry> entries() const { return sorted; }
+  // counts the snapshots published by a ConfigSource, starting with 1
+  uint64_t version() const { return number; }
+  // how many lines had to be tokenized, the others were taken from the last one
+  size_t lines_tokenized() const { return tokenized; }
+
+private:
+  // offsets into text, so unchanged lines can be moved to a new text
+  struct Line {
+    uint32_t begin = 0, end = 0;
+    uint32_t key = 0, key_len = 0;
+    uint32_t value = 0, value_len = 0;
+    bool is_entry = false, has_value = false;
+  };
+  const Entry *find(std::string_view lopt) const;
+
+  std::string text;  // the file, everything else points into it
+  std::vector<Line> lines;
+  std::vector<Entry> sorted;
+  uint64_t number  = 0;
+  size_t tokenized = 0;
+  friend class ConfigSource;
+};
+
+/**
+ * \brief applies a config file to a CheckArg, reapplying it when it changes
+ *
+ * Every line is `name = value`, or just `name` for options without values,
+ * empty lines and lines starting with '#' are ignored.
+ * Names are long options of the CheckArg, unknown ones are errors.
+ *
+ * When the file changes, only the lines that changed are tokenized again.
+ * Callbacks are called, and bound flags updated, only for options
+ * whose values changed, with an empty value if one was removed.
+ * Flags of options given on the command line are left alone.
+ * Readers get consistent snapshots, each new one is swapped in atomically.
+ * A file with errors is not applied, the last snapshot stays.
+ *
+ * The file is watched by a thread of its own, which never touches the CheckArg.
+ * It publishes snapshots and updates bound flags, callbacks are called
+ * by poll() or reload(), on the caller's thread.
+ * Values from the file are seen through snapshots, flags and callbacks only,
+ * CheckArg::value() and isset() keep what the command line and environment gave.
+ */
+class ConfigSource {
+public:
+  ConfigSource() = default;
+  ~ConfigSource();
+
+  ConfigSource(const ConfigSource &)            = delete;
+  ConfigSource &operator=(const ConfigSource &) = delete;
+
+  // apply path to ca and watch it, ca must outlive this
+  int start(CheckArg &ca, const std::string &path);
+  void stop();
+  // apply the file again now
+  int reload();
+  // call the callbacks for what the watcher applied since the last call
+  int poll();
+
+  std::shared_ptr<const ConfigSnapshot> snapshot() const {
+    return current.load(std::memory_order_acquire);
+  }
+  // details of the error the last reload() returned, index is the line number
+  const ParseError &error() const { return err; }
+
+private:
+  // an option of the CheckArg, as start() found it
+  struct Option {
+    std::string name;
+    uint32_t slot;
+    bool has_value;
+  };
+
+  void run();
+  void update();
+  void fail(const ParseError &error, const std::string &text);
+  const Option *option(std::string_view name) const;
+
+  // the bound flags, with what the parse left them at
+  struct Bound {
+    uint32_t slot;
+    FlagBase *flag;
+    bool given;  // on the command line or by the environment, it wins then
+    bool has_base;
+    std::string base;  // restored when the option is removed from the file
+  };
+
+  CheckArg *ca = nullptr;
+  std::vector<Option> options;  // sorted by name
+  std::vector<Bound> bound;
+  std::string path;
+  std::atomic<std::shared_ptr<const ConfigSnapshot>> current;
+  std::shared_ptr<const ConfigSnapshot> delivered;  // to the callbacks, by poll()
+
+  // guards everything update() writes but the snapshot and the flags
+  std::mutex reloading;
+  ParseError next_err;  // of the last update(), taken over by poll()
+  std::string next_err_text;
+  int next_errno = 0;
+
+  ParseError err;
+  std::string err_text;  // of the file that failed, err points into it
+  int inotify_fd = -1;
+  int wakeup[2]  = {-1, -1};  // written to by stop()
+  std::thread thread;
+};
+
+}  // namespace checkarg
+
+#endif  // CHECKARG_CONFIG_HPP
@@ -5,22 +5,97 @@
 #include "config.h"
 
 #include <algorithm>
-#include <locale>
+#include <array>
+#include <cstdint>
+#include <deque>
+
+// static tracepoints for perf and bpftrace, a no-op without sys/sdt.h
+#ifdef HAS_SYS_SDT
+#include <sys/sdt.h>
+#define CA_PROBE(...) STAP_PROBEV(checkargpp, __VA_ARGS__)
+#else
+#define CA_PROBE(...) ((void)0)
+#endif
 
 namespace checkarg {
 
-std::string str_to_upper(const std::string &src);
+// both only handle ASCII, which is all an option name should be
+std::string str_to_upper(std::string_view src);
+void str_to_upper(std::string_view src, char *dst);  // writes src.size() chars
+
+// like str.find(c), but uses AVX2 or SSE2 if the CPU has them
+size_t find_char(std::string_view str, char c);
+// appends the parts of str between each c to out, vectorized like find_char
+void split_char(std::string_view str, char c, std::vector<std::string_view> &out);
+
+constexpr uint32_t no_slot = UINT32_MAX;
+
+constexpr std::array<uint32_t, 256>
+make_short2slot() {
+  std::array<uint32_t, 256> table{};
+  table.fill(no_slot);
+  return table;
+}
+
+// whether options of a type take a single value, which value() returns
+constexpr bool
+single_value(CAValueType type) {
+  return type == CA_VT_REQUIRED || type == CA_VT_FILE;
+}
 
+using Callback =
+  std::function<int(CheckArg *const, const std::string &, const std::string &)>;
+
+// the data of an option needed while parsing, kept small and dense,
+// everything else is in separate arrays indexed by the same slot
 struct Opt {
+  uint32_t seen            = 0;  // generation of the parse the option was given in
   ::CAValueType value_type = CAValueType::CA_VT_NONE;
   char sopt                = 0;
-  std::function<int(CheckArg *const, const std::string &, const std::string &)> cb;
-  std::string help;
-  std::string value;
-  std::string value_name;
+  bool has_cb              = false;
+  char delimiter           = ',';  // where values of CA_VT_LIST options are split
+};
+
+// the data of an option only autohelp() needs
+struct OptHelp {
+  std::string_view help;
+  std::string_view value_name;
+};
+
+struct OptCallback {
+  Callback fn;
+  std::string name;  // callbacks get the option name as std::string
+};
+
+// open-addressing hash of string views, cleared in O(1) by bumping a generation
+class FlatMap {
+public:
+  using Entry = std::pair<std::string_view, std::string_view>;
+
+  void clear();
+  void set(std::string_view key, std::string_view value);  // the last one wins
+  // copy keys and values into text, which must not be one of them
+  void own(std::string &text);
+  const Entry *find(std::string_view key) const;
+  const std::vector<Entry> &entries() const { return items; }
+
+private:
+  struct Bucket {
+    uint32_t generation = 0;  // the bucket is empty unless this is current
+    uint32_t item       = 0;
+  };
+  size_t bucket_of(std::string_view key) const;  // where key is, or would go
+  void grow();
+
+  std::vector<Entry> items;  // in insertion order
+  std::vector<Bucket> buckets;
+  uint32_t generation = 1;
 };
 
 class CheckArgPrivate {
+public:
+  ~CheckArgPrivate();
+
 private:
   CheckArgPrivate(CheckArg *const ca, const std::string &appname);
   CheckArgPrivate(
@@ -29,19 +104,69 @@ private:
     CheckArg *const ca, const std::string &appname, const std::string &desc,
     const std::string &appendix);
 
-  int arg(const std::string &arg);
-  int arg_long(const std::string &arg);
-  int arg_short(const std::string &arg);
-  int call_cb(const std::string &arg);
+  int arg(std::string_view arg);
+  int arg_long(std::string_view arg);
+  int arg_short(std::string_view arg);
+  int call_cb(uint32_t slot);
+
+  // what an argument would be, if it is not the value of the one before it
+  enum ArgKind : uint8_t {
+    AK_POSITIONAL = 0,
+    AK_OPTION     = 1,
+    AK_CONSUMES   = 2,  // an option taking the next argument as its value
+    AK_SEPARATOR  = 4,
+  };
+  uint8_t classify(std::string_view arg) const;
+  bool known_option(std::string_view arg) const;
+
+  bool use_parallel(int argc) const;
+  bool use_cache() const;
+  template<typename GetArg>
+  int parse_cached(int argc, GetArg get);
+  template<typename GetArg>
+  int parse_parallel(int argc, GetArg get);
+
+  // strings given here are borrowed, use keep() to store a copy
+  uint32_t add_opt(
+    char sopt, std::string_view lopt, std::string_view help, Callback cb,
+    CAValueType value_type, std::string_view value_name);
+  void reserve(size_t n);
+  std::string_view keep(std::string str);
 
+  uint32_t find(std::string_view lopt) const;
+  void sort_valid_args() const;
 
-  int ca_error(int eno, const char *info = "!", ...) const;
+  void store_value(uint32_t slot, std::string_view val);
+  // the value of an option, from the command line, environment or its default
+  std::string_view value_of(uint32_t slot) const;
+  void mark_seen(uint32_t slot) { opts[slot].seen = generation; }
+  bool is_seen(uint32_t slot) const { return opts[slot].seen == generation; }
+
+
+  int ca_error(int eno, const char *detail);
+  int ca_error(const ParseError &err);
 
   static std::map<int, std::string> errors;
 
 
-  std::map<std::string, Opt> valid_args;
-  std::map<char, std::string> short2long;
+  // options are stored struct-of-arrays like, indexed by slot
+  std::vector<Opt> opts;
+  std::vector<OptHelp> opt_help;
+  std::vector<std::string_view> defaults;  // data() is null, if there is none
+  std::vector<std::string> values;
+  std::vector<OptCallback> callbacks;
+  std::vector<std::string_view> names;
+
+  // long option to slot, sorted by find() once options were added
+  mutable std::vector<std::pair<std::string_view, uint32_t>> valid_args;
+  mutable bool valid_args_sorted = true;
+  mutable std::array<uint32_t, 256> short2slot = make_short2slot();
+
+  // storage of strings not borrowed from the caller
+  std::deque<std::string> strings;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  // copies of range elements by argv index, reused by the next parse
+  std::deque<std::string> range_args;
 
   std::vector<std::string> pos_args;
 
@@ -52,21 +177,150 @@ private:
   std::string appendix;
   bool pos_arg_sep = false;
   bool cleared     = true;
+  bool print_errors = CA_PRINTERR;
+  // bumped by reset(), an option is set if its `seen` equals this
+  uint32_t generation = 1;
   std::string usage_line;
   std::string posarg_help_descr, posarg_help_usage;
   std::string callname;
   // std::string _argv0;
 
   // state
-  std::string next_is_val_of;
+  uint32_t next_is_val_of = no_slot;
+  ParseError next_is_val_src;  // where next_is_val_of was given, for CA_MISSVAL
+  int cur_index = 0;  // argv index of the argument currently parsed
+  std::string_view cur_arg;  // and the argument itself
+  ParseError error;
+
+  unsigned parse_threads = 1;
+  std::vector<uint8_t> arg_kinds;  // kept between parallel parses
+
+  // argv of the last parse, if positional args are lazy and it can be iterated again
+  bool lazy_pos_args           = false;
+  char *const *argv_ptrs       = nullptr;
+  const std::string *argv_strs = nullptr;
+  int argc                     = 0;
+  int parsed_argc              = 0;  // where the parse loop stopped, at an error
+  bool argv_kept() const { return argv_ptrs || argv_strs; }
+
+  Limits limits;
+  bool has_limits = false;
+  size_t total_bytes = 0, cb_count = 0;  // counted against limits while parsing
+  std::chrono::steady_clock::time_point deadline;
+  int check_limits(std::string_view arg, int index);
+
+  // long options given without being added, if opportunistic,
+  // views into argv while parsing, into adhoc_text after it
+  bool opportunistic = false;
+  FlatMap adhoc;
+  std::string adhoc_text;
+
+  // on-disk cache of parse results, keyed by argv and the options added
+  std::string cache_dir;
+  uint64_t schema_fingerprint() const;
+  std::string cache_path(std::string_view key) const;
+  bool cache_load(const std::string &path, std::string_view key);
+  void cache_store(const std::string &path, std::string_view key) const;
+
+  // entries of CA_VT_DICT options, as views into argv
+  std::vector<std::pair<uint32_t, FlatMap>> dicts;
+  FlatMap *dict_of(uint32_t slot);
+  const FlatMap *dict_of(uint32_t slot) const;
+
+  // items of CA_VT_LIST options, as views into argv
+  std::vector<std::pair<uint32_t, std::vector<std::string_view>>> lists;
+  std::vector<std::string_view> *list_of(uint32_t slot);
+  const std::vector<std::string_view> *list_of(uint32_t slot) const;
+
+  // contents of the files of CA_VT_FILE options by path, kept once mapped
+  FlatMap files;
+  int map_file(std::string_view path, std::string_view &contents);
+
+  // options taking values from environment variables, see apply_env()
+  FlatMap env_binds;  // variable names, in the order bound
+  std::vector<uint32_t> env_bind_slots;  // the slot of each of env_binds
+  std::string env_prefix;
+  std::string env_name;  // scratch space for apply_env()
+  // views into environ, valid if the generation is current
+  std::vector<std::pair<uint32_t, std::string_view>> env_values;
+  void apply_env();
+  bool from_env(uint32_t slot) const {
+    return slot < env_values.size() && env_values[slot].first == generation;
+  }
+
+  // constraints on which options are given, by slots
+  enum ConstraintKind : uint8_t {
+    CK_REQUIRED,  // all of them
+    CK_CONFLICT,  // at most one of them
+    CK_REQUIRES,  // the second one, if the first one is given
+  };
+  struct Constraint {
+    ConstraintKind kind;
+    std::vector<uint32_t> slots;
+    std::string_view rule;  // describing it for errors
+  };
+  std::vector<Constraint> constraints;
+  int add_constraint(
+    ConstraintKind kind, const std::vector<std::string> &lopts, std::string rule);
+
+  // constraints compiled to masks over a presence bitset of the constrained options
+  std::vector<uint32_t> constrained;  // the slot of each bit
+  std::vector<uint64_t> constraint_masks;  // two masks per constraint
+  std::vector<uint64_t> presence;
+  bool constraints_compiled = true;
+  void compile_constraints();
+  int check_constraints();
+
+  // registered features, a feature's index is its place in the map's entries
+  FlatMap features;
+  std::vector<uint64_t> feature_defaults;
+  std::vector<uint64_t> feature_scratch;  // the next feature_bits, built by a parse
+  // what FeatureHandles test, a deque so the words never move
+  std::deque<std::atomic<uint64_t>> feature_bits;
+  uint32_t enable_slot = no_slot, disable_slot = no_slot;
+  // argv index and offset of each item of the enabling and disabling lists
+  std::vector<std::pair<int, size_t>> enable_srcs, disable_srcs;
+  int resolve_features();
+  void publish_features(const std::vector<uint64_t> &words);
+
+  // BK-tree of the long option names, built by suggest() when first needed
+  struct SuggestNode {
+    uint32_t slot;
+    uint32_t dist;  // edit distance to the parent
+    uint32_t first_child  = no_slot;
+    uint32_t next_sibling = no_slot;
+  };
+  std::vector<SuggestNode> suggest_tree;
+  std::vector<uint32_t> suggest_row, suggest_todo;  // kept, so errors don't allocate
+  std::string_view suggest(std::string_view name);
+
+  // paths checked by check_paths() after a parse
+  struct PathOpt {
+    uint32_t slot;
+    uint8_t checks;
+    int index = -1;  // where it was last given, set by store_value()
+  };
+  struct PathJob {
+    std::string_view path;
+    int index;
+    uint8_t checks;
+    const char *failed = nullptr;  // why, if it did
+  };
+  std::vector<PathOpt> path_opts;
+  uint8_t pos_path_checks = 0;
+  std::vector<int> pos_indices;  // argv index of each positional arg, if checked
+  std::vector<PathJob> path_jobs;
+  std::vector<ParseError> path_errors;
+  int check_paths();
+
+  // flags bound to slots, updated by publish_flags() after a parse
+  std::vector<std::pair<uint32_t, FlagBase *>> flags;
+  int publish_flags();
 
   friend class ::CheckArg;
+  friend class ConfigSource;
   friend int
   checkarg::show_autohelp(CheckArg *const, const std::string &, const std::string &);
 };
 
 }  // namespace checkarg
-
-#if not HAS_VASPRINTF
-extern int vasprintf(char **strp, const char *format, va_list ap);
-#endif
@@ -4,10 +4,12 @@
 #include <iostream>
 
 string cb_opt;
+string cb_val;
 
 int
-callback_b(CheckArg *const, const string &o, const string &) {
+callback_b(CheckArg *const, const string &o, const string &v) {
   cb_opt = o;
+  cb_val = v;
   return 0;
 }
 int
@@ -18,6 +20,7 @@ callback_d(CheckArg *const, const string &o, const string &) {
 
 TEST_CASE("options: long non-value options", "[non-val-opt]") {
   cb_opt.clear();
+  cb_val = "unset";
 
   string opt                = GENERATE("alpha", "beta", "gamma", "delta");
   const vector<string> argv = {
@@ -42,6 +45,9 @@ TEST_CASE("options: long non-value options", "[non-val-opt]") {
   // this option never gets passed, so it should not be set
   CHECK(!ca.isset("epsilon"));
 
+  // options without a value have an empty one
+  CHECK(ca.value(opt).empty());
+  if (opt == "beta") CHECK(cb_val.empty());
 
   if (opt == "beta" || opt == "delta") {
     REQUIRE(cb_opt == opt);  // the callback ran!
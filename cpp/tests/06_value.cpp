@@ -161,21 +161,38 @@ TEST_CASE("options: empty value", "[opt-val]") {
     };
   }
 
+  int calls = 0;
   CheckArg ca("test06");
   ca.add('a', "alpha", "non-value opt a", CA_VT_REQUIRED);
   ca.add(
-    'b', "beta", "non-value opt b", [&](auto, auto &o, auto &v) -> int { return 0; },
+    'b', "beta", "non-value opt b",
+    [&](auto, auto &o, auto &v) -> int {
+      calls += v.empty();
+      return 0;
+    },
     CA_VT_REQUIRED);
   ca.add("gamma", "non-value long opt gamma", CA_VT_REQUIRED);
   ca.add(
     "delta", "non-value long opt delta",
-    [&](auto, auto &o, auto &v) -> int { return 0; }, CA_VT_REQUIRED);
+    [&](auto, auto &o, auto &v) -> int {
+      calls += v.empty();
+      return 0;
+    },
+    CA_VT_REQUIRED);
   ca.add('e', "epsilon", "non-value opt e", CA_VT_REQUIRED);
 
   int rc = ca.parse(argv);
 
   INFO("option was:" << argv[1]);
   REQUIRE(CA_ALLOK == rc);  // an empty string as value should not trigger a CA_MISSVAL
+
+  // given, even though empty, so callbacks are called
+  auto opt = argv[1].substr(argv[1].find_first_not_of('-'));
+  opt      = opt.substr(0, opt.find('='));
+  if (opt.size() == 1) opt = opt == "a" ? "alpha" : "beta";
+  CHECK(ca.isset(opt));
+  CHECK(ca.value(opt).empty());
+  CHECK(calls == (opt == "beta" || opt == "delta"));
 }
 
 TEST_CASE("options: special values", "[opt-val]") {
@@ -218,3 +235,27 @@ TEST_CASE("options: special values", "[opt-val]") {
 
   REQUIRE(value == ca.value("input"));
 }
+
+TEST_CASE("options: long names and values", "[opt-val]") {
+  // certificates, JSON, ..., with names of every length around the scan block sizes
+  string blob = "{\"cert\": \"" + string(5000, 'Q') + "==\"}";
+
+  for (int len = 1; len < 70; ++len) {
+    string name(len, 'n');
+    CheckArg ca("test06");
+    ca.add(name, "value option", CA_VT_REQUIRED);
+    ca.add(name + "-flag", "flag option");
+
+    INFO("name length: " << len);
+    REQUIRE(ca.parse(vector<string>{"/test06", "--" + name + "=" + blob}) == CA_ALLOK);
+    CHECK(ca.value(name) == blob);
+
+    REQUIRE(ca.parse(vector<string>{"/test06", "--" + name + "-flag"}) == CA_ALLOK);
+    CHECK(ca.isset(name + "-flag"));
+
+    // error().option points into argv, keep it alive
+    vector<string> argv = {"/test06", "--" + name + "-flag=" + blob};
+    REQUIRE(ca.parse(argv) == CA_INVVAL);
+    CHECK(ca.error().option == name + "-flag");
+  }
+}
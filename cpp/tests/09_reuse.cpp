@@ -101,3 +101,25 @@ TEST_CASE("reuse", "[reuse]") {
   REQUIRE(ca.isset("ng"));
   REQUIRE(ca.value("ng") == "ng-val");
 }
+
+TEST_CASE("reuse: flags and positional args", "[reuse]") {
+  vector<string> argv1 = {"/test09", "-q", "--input=", "file1", "file2"};
+  vector<string> argv2 = {"/test09", "file3"};
+
+  CheckArg ca("test09");
+  ca.add('q', "quiet", "no output");
+  ca.add('i', "input", "file to read from", CA_VT_REQUIRED);
+
+  for (int i = 0; i < 3; ++i) {
+    REQUIRE(ca.parse(argv1) == CA_ALLOK);
+    CHECK(ca.isset("quiet"));
+    CHECK(ca.isset("input"));  // given, even if empty
+    CHECK(ca.value("input").empty());
+    CHECK_THAT(ca.pos_args(), Catch::Matchers::Equals(vector<string>{"file1", "file2"}));
+
+    REQUIRE(ca.parse(argv2) == CA_ALLOK);
+    CHECK(!ca.isset("quiet"));
+    CHECK(!ca.isset("input"));
+    CHECK_THAT(ca.pos_args(), Catch::Matchers::Equals(vector<string>{"file3"}));
+  }
+}
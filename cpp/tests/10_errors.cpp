@@ -0,0 +1,171 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+
+TEST_CASE("errors: unknown long option", "[errors]") {
+  const vector<string> argv = {"/test10", "-i", "in", "--nope=val"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('i', "input", "file to read from", CA_VT_REQUIRED);
+
+  REQUIRE(ca.parse(argv) == CA_INVOPT);
+
+  auto &err = ca.error();
+  CHECK(err.code == CA_INVOPT);
+  CHECK(err.index == 3);
+  CHECK(err.offset == 2);
+  CHECK(err.option == "nope");
+  CHECK(!err.is_short);
+  CHECK(ca.error_message() == "Unknown command line option: --nope!");
+}
+
+TEST_CASE("errors: unknown short option in group", "[errors]") {
+  const vector<string> argv = {"/test10", "-abx"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('a', "alpha", "alpha option");
+  ca.add('b', "beta", "beta option");
+
+  REQUIRE(ca.parse(argv) == CA_INVOPT);
+
+  auto &err = ca.error();
+  CHECK(err.index == 1);
+  CHECK(err.offset == 3);
+  CHECK(err.option == "x");
+  CHECK(err.is_short);
+  CHECK(argv[err.index][err.offset] == 'x');
+  CHECK(ca.error_message() == "Unknown command line option: -x!");
+}
+
+TEST_CASE("errors: value given to non-value option", "[errors]") {
+  const vector<string> argv = {"/test10", "--alpha=1"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('a', "alpha", "alpha option");
+
+  REQUIRE(ca.parse(argv) == CA_INVVAL);
+  CHECK(ca.error().index == 1);
+  CHECK(ca.error().option == "alpha");
+}
+
+TEST_CASE("errors: missing value", "[errors]") {
+  const vector<string> argv = {"/test10", "file", "-qi"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('q', "quiet", "quiet option");
+  ca.add('i', "input", "file to read from", CA_VT_REQUIRED);
+
+  REQUIRE(ca.parse(argv) == CA_MISSVAL);
+
+  auto &err = ca.error();
+  CHECK(err.index == 2);
+  CHECK(err.offset == 2);
+  CHECK(err.option == "i");
+  CHECK(err.is_short);
+  CHECK(ca.error_message() == "Missing value of option: -i!");
+}
+
+TEST_CASE("errors: callback error", "[errors]") {
+  const vector<string> argv = {"/test10", "--alpha"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add("alpha", "alpha option", [](auto, auto &, auto &) -> int { return 42; });
+
+  REQUIRE(ca.parse(argv) == CA_CALLBACK);
+  CHECK(ca.error().cb_code == 42);
+  CHECK(ca.error().option == "alpha");
+  CHECK(ca.error_message() == "Callback returned with error code: 42!");
+}
+
+TEST_CASE("errors: cleared on successful reparse", "[errors]") {
+  const vector<string> argv1 = {"/test10", "-x"};
+  const vector<string> argv2 = {"/test10", "-a"};
+
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('a', "alpha", "alpha option");
+
+  REQUIRE(ca.parse(argv1) == CA_INVOPT);
+  REQUIRE(ca.parse(argv2) == CA_ALLOK);
+  CHECK(ca.error().code == CA_ALLOK);
+  CHECK(ca.error().index == -1);
+}
+
+TEST_CASE("errors: suggestions for unknown long options", "[errors]") {
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  ca.add('v', "verbose", "be verbose");
+  ca.add('i', "input", "file to read from", CA_VT_REQUIRED);
+  ca.add("output-format", "format to write", CA_VT_REQUIRED);
+
+  // the error points into argv, so it is kept as long as the error is looked at
+  const vector<string> argv1 = {"/test10", "--verbsoe"};
+  const vector<string> argv2 = {"/test10", "--output_format=x"};
+  const vector<string> argv3 = {"/test10", "--quiet"};
+
+  REQUIRE(ca.parse(argv1) == CA_INVOPT);
+  CHECK(ca.error().option == "verbsoe");
+  CHECK(ca.error().suggestion == "verbose");
+  CHECK(ca.error_message()
+        == "Unknown command line option: --verbsoe! Did you mean --verbose?");
+
+  REQUIRE(ca.parse(argv2) == CA_INVOPT);
+  CHECK(ca.error().suggestion == "output-format");
+
+  // nothing close enough
+  REQUIRE(ca.parse(argv3) == CA_INVOPT);
+  CHECK(ca.error().suggestion.empty());
+  CHECK(ca.error_message() == "Unknown command line option: --quiet!");
+
+  // options added later are suggested, too
+  ca.add("quite", "be quite");
+  REQUIRE(ca.parse(argv3) == CA_INVOPT);
+  CHECK(ca.error().suggestion == "quite");
+}
+
+TEST_CASE("errors: suggestions from many options", "[errors]") {
+  CheckArg ca("test10");
+  ca.set_print_errors(false);
+  vector<string> names;
+  for (int i = 0; i < 6000; ++i) {
+    names.push_back("option-" + std::to_string(i * 7919 % 100000));
+    ca.add(names.back(), "some option");
+  }
+
+  for (string typo : {"optoin-1234", "option-99999x", "opton-4242", "xyz"}) {
+    INFO("typo " << typo);
+    const vector<string> argv = {"/test10", "--" + typo};
+    REQUIRE(ca.parse(argv) == CA_INVOPT);
+    auto suggestion = ca.error().suggestion;
+    if (typo == "xyz") {
+      CHECK(suggestion.empty());
+      continue;
+    }
+    REQUIRE(!suggestion.empty());
+
+    // the suggestion is as close as any name is
+    auto distance = [](std::string_view a, std::string_view b) {
+      vector<size_t> row(b.size() + 1);
+      for (size_t j = 0; j <= b.size(); ++j) row[j] = j;
+      for (size_t i = 1; i <= a.size(); ++i) {
+        size_t diag = row[0];
+        row[0]      = i;
+        for (size_t j = 1; j <= b.size(); ++j) {
+          size_t up = row[j];
+          row[j]    = std::min({up + 1, row[j - 1] + 1, diag + (a[i - 1] != b[j - 1])});
+          diag      = up;
+        }
+      }
+      return row[b.size()];
+    };
+    size_t best = SIZE_MAX;
+    for (auto &name : names) best = std::min(best, distance(typo, name));
+    CHECK(distance(typo, suggestion) == best);
+  }
+}
@@ -0,0 +1,131 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+// 50 options: every 5th has a callback, every other one takes a value
+static void
+add_options(CheckArg &ca, int &cb_calls) {
+  for (int i = 0; i < 50; ++i) {
+    string lopt = "option-" + std::to_string(i);
+    char sopt   = i < 26 ? 'a' + i : 0;
+    auto vt     = i % 2 ? CA_VT_REQUIRED : CA_VT_NONE;
+    if (i % 5 == 0) {
+      ca.add(
+        sopt, lopt, "help of " + lopt,
+        [&cb_calls](auto, auto &, auto &) -> int {
+          ++cb_calls;
+          return CA_ALLOK;
+        },
+        vt);
+    }
+    else {
+      ca.add(sopt, lopt, "help of " + lopt, vt);
+    }
+  }
+}
+
+TEST_CASE("allocations: first parse", "[allocations]") {
+  const vector<string> argv = {"/test11", "--option-1=value", "-a", "file"};
+
+  int cb_calls = 0;
+  CheckArg ca("test11");
+  add_options(ca, cb_calls);
+
+  // one for the vector of positional args, everything else fits into SSO
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 1);
+}
+
+TEST_CASE("allocations: reparse of a warmed-up CheckArg", "[allocations]") {
+  const vector<string> argv = {
+    "/usr/local/bin/test11-with-a-long-name",
+    "--option-0",
+    "--option-1=a value that does not fit into SSO",
+    "-d",
+    "value of d, which does not fit into SSO either",
+    "-ceif",
+    "value of f",
+    "--option-13",
+    "value of option-13",
+    "positional-1",
+    "-g",
+    "positional-2",
+    "--option-49=last one",
+    "--",
+    "--positional-3",
+  };
+  vector<const char *> cargv;
+  for (auto &arg : argv) cargv.push_back(arg.c_str());
+
+  int cb_calls = 0;
+  CheckArg ca("test11");
+  add_options(ca, cb_calls);
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  REQUIRE(ca.pos_args().size() == 3);
+  int calls_per_parse = cb_calls;
+
+  SECTION("std::vector") {
+    CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+    CHECK(cb_calls == 2 * calls_per_parse);
+  }
+  SECTION("argc, argv") {
+    CHECK(
+      alloc_count::count([&] {
+        REQUIRE(ca.parse(cargv.size(), (char **)cargv.data()) == CA_ALLOK);
+      })
+      == 0);
+    CHECK(cb_calls == 2 * calls_per_parse);
+  }
+  SECTION("many reparses") {
+    CHECK(
+      alloc_count::count([&] {
+        for (int i = 0; i < 100; ++i) REQUIRE(ca.parse(argv) == CA_ALLOK);
+      })
+      == 0);
+    CHECK(cb_calls == 101 * calls_per_parse);
+  }
+
+  CHECK(ca.value("option-1") == "a value that does not fit into SSO");
+  CHECK(ca.value("option-3") == "value of d, which does not fit into SSO either");
+  CHECK(ca.value("option-13") == "value of option-13");
+}
+
+TEST_CASE("allocations: errors", "[allocations]") {
+  const vector<string> argv1 = {"/test11", "--option-1=value", "--unknown-option"};
+  const vector<string> argv2 = {"/test11", "-aZ"};
+  const vector<string> argv3 = {"/test11", "--option-0=value"};
+  const vector<string> argv4 = {"/test11", "--option-1"};
+
+  int cb_calls = 0;
+  CheckArg ca("test11");
+  ca.set_print_errors(false);
+  add_options(ca, cb_calls);
+  REQUIRE(ca.parse(argv1) == CA_INVOPT);
+
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv1) == CA_INVOPT); }) == 0);
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv2) == CA_INVOPT); }) == 0);
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv3) == CA_INVVAL); }) == 0);
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv4) == CA_MISSVAL); }) == 0);
+}
+
+TEST_CASE("allocations: over-aligned ones are counted, too", "[allocations]") {
+  struct alignas(64) Line {
+    char bytes[64];
+  };
+  // kept somewhere the compiler can't see, so allocating isn't optimized out
+  static void *volatile sink;
+  CHECK(alloc_count::count([] { sink = new Line; }) == 1);
+  delete static_cast<Line *>(sink);
+  if (!alloc_count::counts_aligned_malloc()) return;
+  CHECK(alloc_count::count([] { sink = aligned_alloc(64, 128); }) == 1);
+  free(sink);
+  CHECK(alloc_count::count([] {
+          void *ptr = nullptr;
+          REQUIRE(posix_memalign(&ptr, 64, 128) == 0);
+          sink = ptr;
+        })
+        == 1);
+  free(sink);
+}
@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+using checkarg::OptSpec;
+
+static int
+count_cb(CheckArg *const, const string &, const string &) {
+  return CA_ALLOK;
+}
+
+// clang-format off
+constexpr OptSpec specs[] = {
+  {.sopt = 'i', .lopt = "input",  .help = "file to read from",
+   .value_type = CA_VT_REQUIRED},
+  {.sopt = 'o', .lopt = "output", .help = "file to write to",
+   .value_type = CA_VT_REQUIRED, .value_name = "FILE"},
+  {.sopt = 'v', .lopt = "verbose", .help = "more output", .cb = count_cb},
+  {.lopt = "dry-run", .help = "do nothing"},
+};
+// clang-format on
+
+
+TEST_CASE("add_all: parsing", "[add_all]") {
+  const vector<string> argv = {"/test12", "-vi", "in.txt", "--output=out.txt", "file"};
+
+  CheckArg ca("test12");
+  REQUIRE(ca.add_all(specs) == CA_ALLOK);
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.isset("verbose"));
+  CHECK(!ca.isset("dry-run"));
+  CHECK(ca.value("input") == "in.txt");
+  CHECK(ca.value("output") == "out.txt");
+  CHECK_THAT(ca.pos_args(), Catch::Matchers::Equals(vector<string>{"file"}));
+}
+
+TEST_CASE("add_all: autohelp", "[add_all]") {
+  CheckArg ca("test12");
+  ca.add_all(specs);
+
+  REQUIRE(ca.autohelp() ==
+    "Usage: test12 [options]\n"
+    "\n"
+    "Options:\n"
+    "       --dry-run      do nothing\n"
+    "   -i, --input=INPUT  file to read from\n"
+    "   -o, --output=FILE  file to write to\n"
+    "   -v, --verbose      more output\n"
+  );
+}
+
+TEST_CASE("add_all: mixed with add()", "[add_all]") {
+  const vector<string> argv = {"/test12", "-x", "--input", "in.txt"};
+
+  CheckArg ca("test12");
+  ca.add('x', "extra", "added separately");
+  ca.add_all(specs);
+  // replaces the one from specs
+  ca.add('I', "input", "file to read from", CA_VT_REQUIRED);
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.isset("extra"));
+  CHECK(ca.value("input") == "in.txt");
+}
+
+TEST_CASE("add_all: allocations", "[add_all]") {
+  vector<OptSpec> many;
+  vector<string> names;
+  names.reserve(1000);
+  for (int i = 0; i < 1000; ++i) {
+    names.push_back("option-number-" + std::to_string(i));
+    many.push_back({
+      .lopt = names.back(), .help = "some option", .value_type = CA_VT_REQUIRED});
+  }
+
+  CheckArg ca("test12");
+  // one for each of the 7 option tables, one block for all generated value names
+  // and one for the list of those blocks
+  CHECK(alloc_count::count([&] { ca.add_all(many); }) == 9);
+
+  const vector<string> argv = {"/test12", "--option-number-999=x"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.value("option-number-999") == "x");
+}
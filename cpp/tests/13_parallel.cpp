@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+
+static void
+add_options(CheckArg &ca) {
+  ca.add('a', "alpha", "alpha option");
+  ca.add('b', "beta", "beta option", CA_VT_REQUIRED);
+  ca.add('c', "gamma", "gamma option", CA_VT_REQUIRED);
+  ca.add("delta", "delta option");
+}
+
+// a long command line mixing all ways to give options and values
+static vector<string>
+make_argv(int count) {
+  vector<string> argv = {"/test13"};
+  for (int i = 0; static_cast<int>(argv.size()) < count; ++i) {
+    switch (i % 9) {
+      case 0: argv.push_back("-ab"); argv.push_back("-positional"); break;
+      case 1: argv.push_back("--gamma"); argv.push_back("--delta"); break;
+      case 2: argv.push_back("-cgamma-" + std::to_string(i)); break;
+      case 3: argv.push_back("--beta=beta-" + std::to_string(i)); break;
+      case 4: argv.push_back("-b"); argv.push_back("value"); break;
+      case 5: argv.push_back("--delta"); break;
+      case 6: argv.push_back(""); break;
+      case 7: argv.push_back("-ba"); break;
+      default: argv.push_back("file-" + std::to_string(i)); break;
+    }
+  }
+  return argv;
+}
+
+static void
+compare(const vector<string> &argv, unsigned threads) {
+  CheckArg seq("test13"), par("test13");
+  add_options(seq);
+  add_options(par);
+  par.set_parse_threads(threads);
+
+  int rc = seq.parse(argv);
+  CHECK(par.parse(argv) == rc);
+  CHECK(par.error().index == seq.error().index);
+  CHECK(par.pos_args() == seq.pos_args());
+  for (auto opt : {"alpha", "beta", "gamma", "delta"}) {
+    CHECK(par.isset(opt) == seq.isset(opt));
+    CHECK(par.value(opt) == seq.value(opt));
+  }
+}
+
+TEST_CASE("parallel: same result as sequential", "[parallel]") {
+  auto argv = make_argv(50000);
+
+  SECTION("2 threads") { compare(argv, 2); }
+  SECTION("3 threads") { compare(argv, 3); }
+  SECTION("one per core") { compare(argv, 0); }
+
+  SECTION("separator") {
+    argv.insert(argv.begin() + 30000, "--");
+    compare(argv, 4);
+  }
+
+  SECTION("error") {
+    argv.insert(argv.begin() + 30000, "--unknown");
+    compare(argv, 4);
+  }
+
+  SECTION("missing value") {
+    argv.push_back("--beta");
+    compare(argv, 4);
+  }
+}
+
+TEST_CASE("parallel: reuse", "[parallel]") {
+  auto argv = make_argv(20000);
+
+  CheckArg ca("test13");
+  add_options(ca);
+  ca.set_parse_threads(4);
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  auto count = ca.pos_args().size();
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.pos_args().size() == count);
+
+  // short command lines are parsed sequentially
+  REQUIRE(ca.parse(vector<string>{"/test13", "-a", "file"}) == CA_ALLOK);
+  CHECK(ca.isset("alpha"));
+  CHECK(!ca.isset("beta"));
+  CHECK(ca.pos_args() == vector<string>{"file"});
+}
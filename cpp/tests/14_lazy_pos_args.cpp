@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+#include <ranges>
+
+
+static_assert(std::ranges::input_range<CheckArg::PosArgRange>);
+
+static void
+add_options(CheckArg &ca) {
+  ca.add('a', "alpha", "alpha option");
+  ca.add('b', "beta", "beta option", CA_VT_REQUIRED);
+  ca.add('c', "gamma", "gamma option", CA_VT_REQUIRED);
+}
+
+static vector<string>
+collect(const CheckArg &ca) {
+  vector<string> result;
+  for (auto arg : ca.pos_args_range()) result.emplace_back(arg);
+  return result;
+}
+
+TEST_CASE("lazy pos args: same as pos_args()", "[lazy]") {
+  vector<string> argv = GENERATE(
+    vector<string>{"/test14"},
+    vector<string>{"/test14", "file1", "-a", "file2"},
+    vector<string>{"/test14", "-b", "file1", "--beta", "-a", "file2", ""},
+    vector<string>{"/test14", "-bvalue", "-ab", "-", "--beta=x", "file1"},
+    vector<string>{"/test14", "-ac", "--gamma", "file1", "--", "-a", "--beta"},
+    vector<string>{"/test14", "file1", "--unknown", "file2"},
+    vector<string>{"/test14", "file1", "-xa", "file2"},
+    vector<string>{"/test14", "file1", "--beta"});
+
+  CheckArg eager("test14"), lazy("test14");
+  add_options(eager);
+  add_options(lazy);
+  lazy.set_lazy_pos_args(true);
+
+  INFO("argv: " << argv);
+  int rc = eager.parse(argv);
+  REQUIRE(lazy.parse(argv) == rc);
+  CHECK(lazy.pos_args().empty());
+  CHECK(collect(lazy) == eager.pos_args());
+  CHECK(collect(eager) == eager.pos_args());
+  CHECK(lazy.isset("alpha") == eager.isset("alpha"));
+  CHECK(lazy.value("beta") == eager.value("beta"));
+}
+
+TEST_CASE("lazy pos args: collected ones don't need argv", "[lazy]") {
+  CheckArg ca("test14");
+  add_options(ca);
+
+  {
+    vector<string> argv = {"/test14", "file1", "-b", "x", "file2"};
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+  }
+  CHECK(collect(ca) == vector<string>{"file1", "file2"});
+}
+
+TEST_CASE("lazy pos args: argc and argv", "[lazy]") {
+  const char *argv[] = {"/test14", "-a", "file1", "--beta", "b", "file2", nullptr};
+
+  CheckArg ca("test14");
+  add_options(ca);
+  ca.set_lazy_pos_args(true);
+
+  // nothing parsed yet
+  CHECK(collect(ca).empty());
+
+  REQUIRE(ca.parse(6, const_cast<char **>(argv)) == CA_ALLOK);
+  CHECK(collect(ca) == vector<string>{"file1", "file2"});
+
+  // the range can be iterated again, but not after a reset
+  CHECK(collect(ca) == vector<string>{"file1", "file2"});
+  ca.reset();
+  CHECK(collect(ca).empty());
+}
+
+TEST_CASE("lazy pos args: no allocations", "[lazy][allocations]") {
+  vector<string> argv = {"/test14", "--alpha"};
+  for (int i = 0; i < 1000; ++i) argv.push_back("some/long/path/to/file-" + std::to_string(i));
+
+  CheckArg ca("test14");
+  add_options(ca);
+  ca.set_lazy_pos_args(true);
+
+  size_t count = 0;
+  CHECK(alloc_count::count([&] {
+          REQUIRE(ca.parse(argv) == CA_ALLOK);
+          for (auto arg : ca.pos_args_range()) count += !arg.empty();
+        }) == 0);
+  CHECK(count == 1000);
+}
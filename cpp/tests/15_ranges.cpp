@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+#include <list>
+#include <ranges>
+#include <span>
+#include <sstream>
+#include <string_view>
+
+
+static void
+add_options(CheckArg &ca) {
+  ca.add('a', "alpha", "alpha option");
+  ca.add('b', "beta", "beta option", CA_VT_REQUIRED);
+}
+
+static void
+check_result(CheckArg &ca) {
+  CHECK(ca.isset("alpha"));
+  CHECK(ca.value("beta") == "b-val");
+  CHECK(ca.pos_args() == vector<string>{"file1", "file2"});
+
+  vector<string> range;
+  for (auto arg : ca.pos_args_range()) range.emplace_back(arg);
+  CHECK(range == vector<string>{"file1", "file2"});
+}
+
+TEST_CASE("ranges: any range of strings", "[ranges]") {
+  CheckArg ca("test15");
+  add_options(ca);
+
+  SECTION("span of const char *") {
+    const char *argv[] = {"/test15", "-a", "file1", "--beta", "b-val", "file2"};
+    REQUIRE(ca.parse(std::span<const char *>(argv)) == CA_ALLOK);
+    check_result(ca);
+  }
+
+  SECTION("vector of string_view") {
+    vector<std::string_view> argv = {"/test15", "-a", "file1", "-bb-val", "file2"};
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+    check_result(ca);
+  }
+
+  SECTION("list of strings") {
+    std::list<string> argv = {"/test15", "--alpha", "file1", "--beta=b-val", "file2"};
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+    check_result(ca);
+  }
+
+  SECTION("tokens of a string, iterable only once") {
+    std::istringstream cmdline("/test15 -a file1 --beta b-val file2");
+    REQUIRE(ca.parse(std::views::istream<string>(cmdline)) == CA_ALLOK);
+    check_result(ca);
+  }
+
+  SECTION("non-const vector of strings") {
+    vector<string> argv = {"/test15", "-a", "file1", "--beta", "b-val", "file2"};
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+    check_result(ca);
+  }
+}
+
+TEST_CASE("ranges: lazy pos args", "[ranges][lazy]") {
+  CheckArg ca("test15");
+  add_options(ca);
+  ca.set_lazy_pos_args(true);
+
+  // a vector can be iterated again, so positional args are found lazily
+  vector<string> strings = {"/test15", "-a", "file1", "--beta", "b-val", "file2"};
+  REQUIRE(ca.parse(strings) == CA_ALLOK);
+  CHECK(ca.pos_args().empty());
+
+  // an input range can't, so they're collected
+  std::istringstream cmdline("/test15 -a file1 --beta b-val file2");
+  REQUIRE(ca.parse(std::views::istream<string>(cmdline)) == CA_ALLOK);
+  check_result(ca);
+}
+
+TEST_CASE("ranges: temporary elements", "[ranges]") {
+  CheckArg ca("test15");
+  ca.add('D', "define", "define a macro", CA_VT_DICT);
+  ca.add('t', "tags", "tags to use", CA_VT_LIST);
+  ca.set_opportunistic(true);
+
+  auto check = [&ca] {
+    CHECK(ca.value("define", "A") == "1");
+    CHECK(ca.value("define", "B") == "2");
+    auto defines = ca.dict("define");
+    REQUIRE(defines.size() == 2);
+    CHECK(defines[0] == std::pair<std::string_view, std::string_view>{"A", "1"});
+    CHECK(defines[1] == std::pair<std::string_view, std::string_view>{"B", "2"});
+    auto tags = ca.values("tags");
+    CHECK(vector<string>(tags.begin(), tags.end()) == vector<string>{"x", "y", "z"});
+    CHECK(ca.value("plugin.size") == "10");
+    auto adhoc = ca.adhoc_options();
+    REQUIRE(adhoc.size() == 2);
+    CHECK(adhoc[0].first == "plugin.size");
+    CHECK(adhoc[1].first == "flag");
+    CHECK(ca.pos_args() == vector<string>{"file"});
+  };
+
+  SECTION("strings returned by a transforming view") {
+    vector<std::string_view> words = {
+      "/test15", "-DA=1", "--define", "B=2", "--tags=x,y", "-t", "z",
+      "--plugin.size=10", "--flag", "file"};
+    auto argv = words | std::views::transform([](std::string_view w) { return string(w); });
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+    check();
+  }
+
+  SECTION("tokens read into one buffer") {
+    std::istringstream cmdline(
+      "/test15 -DA=1 --define B=2 --tags=x,y -t z --plugin.size=10 --flag file");
+    REQUIRE(ca.parse(std::views::istream<string>(cmdline)) == CA_ALLOK);
+    check();
+  }
+
+  SECTION("errors point at the copy") {
+    std::istringstream cmdline("/test15 -DA=1 -x file");
+    REQUIRE(ca.parse(std::views::istream<string>(cmdline)) == CA_INVOPT);
+    CHECK(ca.error().index == 2);
+    CHECK(ca.error().option == "x");
+    CHECK(ca.value("define", "A") == "1");
+  }
+}
+
+TEST_CASE("ranges: errors", "[ranges]") {
+  CheckArg ca("test15");
+  add_options(ca);
+
+  vector<std::string_view> empty;
+  CHECK(ca.parse(empty) == CA_ERROR);
+
+  vector<std::string_view> argv = {"/test15", "file1", "--gamma", "file2"};
+  REQUIRE(ca.parse(argv) == CA_INVOPT);
+  CHECK(ca.error().index == 2);
+  CHECK(ca.error().option == "gamma");
+  CHECK(ca.pos_args() == vector<string>{"file1"});
+}
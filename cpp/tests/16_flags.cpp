@@ -0,0 +1,158 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "checkargpp_admin.hpp"
+#include "test.hpp"
+
+#include <cerrno>
+#include <fstream>
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+
+TEST_CASE("flags: updated by parse", "[flags]") {
+  checkarg::Flag<bool> verbose;
+  checkarg::Flag<long> workers(4);
+  checkarg::Flag<double> ratio(0.5);
+  checkarg::Flag<string> name("default");
+
+  CheckArg ca("test16");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('w', "workers", "number of workers", CA_VT_REQUIRED);
+  ca.add("ratio", "some ratio", CA_VT_REQUIRED);
+  ca.add("name", "some name", CA_VT_REQUIRED);
+  REQUIRE(ca.bind("verbose", verbose) == CA_ALLOK);
+  REQUIRE(ca.bind("workers", workers) == CA_ALLOK);
+  REQUIRE(ca.bind("ratio", ratio) == CA_ALLOK);
+  REQUIRE(ca.bind("name", name) == CA_ALLOK);
+  CHECK(ca.bind("unknown", verbose) == CA_INVOPT);
+
+  REQUIRE(ca.parse(vector<string>{"/test16", "-v", "-w", "16", "--ratio=0.25", "--name=x"})
+          == CA_ALLOK);
+  CHECK(verbose);
+  CHECK(workers == 16);
+  CHECK(ratio == 0.25);
+  CHECK(*name.get() == "x");
+
+  // a snapshot stays valid after a reparse
+  auto old_name = name.get();
+
+  // not given means default
+  REQUIRE(ca.parse(vector<string>{"/test16"}) == CA_ALLOK);
+  CHECK(!verbose);
+  CHECK(workers == 4);
+  CHECK(ratio == 0.5);
+  CHECK(*name.get() == "default");
+  CHECK(*old_name == "x");
+
+  // invalid values fail the parse and leave all flags alone
+  REQUIRE(ca.parse(vector<string>{"/test16", "-w", "8"}) == CA_ALLOK);
+  vector<string> argv = {"/test16", "--name=y", "-w", "many"};
+  REQUIRE(ca.parse(argv) == CA_BADVAL);
+  CHECK(ca.error().option == "workers");
+  CHECK(workers == 8);
+  CHECK(*name.get() == "default");
+}
+
+// sends one command, returns everything up to and including the final "ok" or "error"
+static string
+send_command(const string &path, const string &cmd) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  REQUIRE(fd >= 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path.c_str());
+  REQUIRE(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+  REQUIRE(write(fd, cmd.data(), cmd.size()) == ssize_t(cmd.size()));
+
+  string answer;
+  char buf[256];
+  while (answer.find("ok\n") == string::npos && answer.find("error") == string::npos) {
+    auto got = read(fd, buf, sizeof(buf));
+    REQUIRE(got > 0);
+    answer.append(buf, got);
+  }
+  close(fd);
+  return answer;
+}
+
+TEST_CASE("flags: admin server", "[flags][admin]") {
+  checkarg::Flag<long> workers(4);
+  checkarg::Flag<string> mode("fast");
+
+  CheckArg ca("test16");
+  ca.add("workers", "number of workers", CA_VT_REQUIRED);
+  ca.add("mode", "some mode", CA_VT_REQUIRED);
+  REQUIRE(ca.bind("workers", workers, true) == CA_ALLOK);
+  REQUIRE(ca.bind("mode", mode) == CA_ALLOK);
+  REQUIRE(ca.parse(vector<string>{"/test16", "--workers=2"}) == CA_ALLOK);
+
+  char dir[] = "/tmp/test16-XXXXXX";
+  REQUIRE(mkdtemp(dir));
+  string path = string(dir) + "/admin.sock";
+
+  checkarg::AdminServer admin;
+  REQUIRE(admin.start(ca, path) == CA_ALLOK);
+
+  CHECK(send_command(path, "list\n") == "workers=2 rw\nmode=fast ro\nok\n");
+  CHECK(send_command(path, "get workers\n") == "workers=2\nok\n");
+
+  CHECK(send_command(path, "set workers 12\n") == "ok\n");
+  CHECK(workers == 12);
+  CHECK(send_command(path, "set workers twelve\n") == "error: invalid value\n");
+  CHECK(send_command(path, "set mode slow\n") == "error: flag is read-only\n");
+  CHECK(send_command(path, "get nothing\n") == "error: unknown flag\n");
+  CHECK(send_command(path, "reboot\n") == "error: unknown command\n");
+  CHECK(*mode.get() == "fast");
+
+  admin.stop();
+  CHECK(access(path.c_str(), F_OK) != 0);
+  rmdir(dir);
+}
+
+TEST_CASE("flags: admin server socket", "[flags][admin]") {
+  checkarg::Flag<long> workers(4);
+  CheckArg ca("test16");
+  ca.add("workers", "number of workers", CA_VT_REQUIRED);
+  REQUIRE(ca.bind("workers", workers, true) == CA_ALLOK);
+
+  char dir[] = "/tmp/test16-XXXXXX";
+  REQUIRE(mkdtemp(dir));
+  string path = string(dir) + "/admin.sock";
+
+  // anything but a socket is left alone
+  std::ofstream(path) << "precious";
+  checkarg::AdminServer admin;
+  errno = 0;
+  CHECK(admin.start(ca, path) == CA_ERROR);
+  CHECK(errno == EEXIST);
+  CHECK(access(path.c_str(), F_OK) == 0);
+  unlink(path.c_str());
+
+  // a stale socket is replaced, the new one is only for the owner
+  int stale = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path.c_str());
+  REQUIRE(bind(stale, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+  close(stale);
+  REQUIRE(admin.start(ca, path) == CA_ALLOK);
+  struct stat st;
+  REQUIRE(lstat(path.c_str(), &st) == 0);
+  CHECK((st.st_mode & 0777) == 0600);
+
+  // an idle client is dropped, so the next one is served
+  admin.set_client_timeout(100);
+  int idle = socket(AF_UNIX, SOCK_STREAM, 0);
+  REQUIRE(connect(idle, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+  REQUIRE(write(idle, "get", 3) == 3);
+  CHECK(send_command(path, "get workers\n") == "workers=4\nok\n");
+  char c;
+  CHECK(read(idle, &c, 1) == 0);
+  close(idle);
+
+  admin.stop();
+  rmdir(dir);
+}
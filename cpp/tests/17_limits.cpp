@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+#include <thread>
+
+
+TEST_CASE("limits", "[limits]") {
+  int cb_calls = 0;
+  CheckArg ca("test17");
+  ca.add('v', "verbose", "more verbose", [&cb_calls](auto, auto &, auto &) -> int {
+    ++cb_calls;
+    return CA_ALLOK;
+  });
+  ca.add('i', "input", "input file", CA_VT_REQUIRED);
+
+  vector<string> argv = {"/test17", "-vvv", "--input=file", "pos1", "pos2"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+
+  SECTION("argument count") {
+    ca.set_limits({.max_args = 5});
+    CHECK(ca.parse(argv) == CA_ALLOK);
+    ca.set_limits({.max_args = 4});
+    CHECK(ca.parse(argv) == CA_LIMIT);
+    CHECK(ca.error().index == 4);
+    CHECK(string(ca.error().detail) == "too many arguments");
+    CHECK(ca.error_message() == "Parse limit exceeded: too many arguments!");
+  }
+
+  SECTION("argument length") {
+    ca.set_limits({.max_arg_length = 12});
+    CHECK(ca.parse(argv) == CA_ALLOK);
+    ca.set_limits({.max_arg_length = 11});
+    CHECK(ca.parse(argv) == CA_LIMIT);
+    CHECK(ca.error().index == 2);
+    CHECK(string(ca.error().detail) == "argument too long");
+  }
+
+  SECTION("total bytes") {
+    ca.set_limits({.max_total_bytes = 31});
+    CHECK(ca.parse(argv) == CA_ALLOK);
+    ca.set_limits({.max_total_bytes = 30});
+    CHECK(ca.parse(argv) == CA_LIMIT);
+    CHECK(ca.error().index == 4);
+  }
+
+  SECTION("callbacks") {
+    cb_calls = 0;
+    ca.set_limits({.max_callbacks = 2});
+    CHECK(ca.parse(vector<string>{"/test17", "-vv"}) == CA_ALLOK);
+    CHECK(ca.parse(vector<string>{"/test17", "-vvvvvvvvvvvvvvvvvvvv"}) == CA_LIMIT);
+    CHECK(string(ca.error().detail) == "too many callbacks");
+    CHECK(cb_calls == 4);
+  }
+
+  SECTION("time") {
+    ca.add("slow", "slow option", [](auto, auto &, auto &) -> int {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      return CA_ALLOK;
+    });
+    ca.set_limits({.max_time = std::chrono::milliseconds(10)});
+    CHECK(ca.parse(argv) == CA_ALLOK);
+    CHECK(ca.parse(vector<string>{"/test17", "--slow", "pos1"}) == CA_LIMIT);
+    CHECK(ca.error().index == 2);
+    CHECK(string(ca.error().detail) == "parsing took too long");
+  }
+
+  SECTION("disabled again") {
+    ca.set_limits({.max_args = 1});
+    CHECK(ca.parse(argv) == CA_LIMIT);
+    ca.set_limits({});
+    CHECK(ca.parse(argv) == CA_ALLOK);
+  }
+}
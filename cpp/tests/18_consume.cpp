@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+
+// runs parse_consume() on a copy of args, returns what is left in argv
+static vector<string>
+consume(CheckArg &ca, vector<string> args, int expected_rc = CA_ALLOK) {
+  vector<char *> argv;
+  for (auto &arg : args) argv.push_back(arg.data());
+  argv.push_back(nullptr);
+
+  int argc = args.size();
+  REQUIRE(ca.parse_consume(argc, argv.data()) == expected_rc);
+  REQUIRE(argv[argc] == nullptr);
+  return vector<string>(argv.begin(), argv.begin() + argc);
+}
+
+TEST_CASE("consume: known options are removed", "[consume]") {
+  CheckArg ca("test18");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+
+  SECTION("only known options") {
+    CHECK(consume(ca, {"/test18", "-v", "--output", "out"}) == vector<string>{"/test18"});
+    CHECK(ca.isset("verbose"));
+    CHECK(ca.value("output") == "out");
+  }
+
+  SECTION("unknown options and positional args pass through in order") {
+    auto left = consume(
+      ca, {"/test18", "--gtk-debug=all", "-v", "file1", "-x", "-oout", "--unknown", "value",
+           "-vo", "out2", "file2"});
+    CHECK(
+      left
+      == vector<string>{"/test18", "--gtk-debug=all", "file1", "-x", "--unknown", "value",
+                        "file2"});
+    CHECK(ca.value("output") == "out2");
+    CHECK(ca.pos_args() == vector<string>{"file1", "value", "file2"});
+  }
+
+  SECTION("groups with an unknown option pass through whole") {
+    CHECK(consume(ca, {"/test18", "-vx"}) == vector<string>{"/test18", "-vx"});
+    CHECK(!ca.isset("verbose"));
+  }
+
+  SECTION("everything after a separator is kept") {
+    auto left = consume(ca, {"/test18", "-v", "--", "-v", "--output", "x"});
+    CHECK(left == vector<string>{"/test18", "--", "-v", "--output", "x"});
+    CHECK(ca.pos_args() == vector<string>{"-v", "--output", "x"});
+  }
+
+  SECTION("errors leave the rest") {
+    auto left = consume(ca, {"/test18", "-v", "a", "--verbose=x", "b"}, CA_INVVAL);
+    CHECK(left == vector<string>{"/test18", "a", "--verbose=x", "b"});
+    CHECK(ca.error().index == 3);
+
+    left = consume(ca, {"/test18", "-v", "--output"}, CA_MISSVAL);
+    CHECK(left == vector<string>{"/test18"});
+  }
+
+  SECTION("limits count unknown options passed through") {
+    ca.set_limits({.max_args = 3});
+    auto left = consume(ca, {"/test18", "--a", "-b", "--c", "-v"}, CA_LIMIT);
+    CHECK(left == vector<string>{"/test18", "--a", "-b", "--c", "-v"});
+    CHECK(ca.error().index == 3);
+    CHECK(string(ca.error().detail) == "too many arguments");
+
+    ca.set_limits({.max_arg_length = 8});
+    left = consume(ca, {"/test18", "-v", "--unknown=value"}, CA_LIMIT);
+    CHECK(left == vector<string>{"/test18", "--unknown=value"});
+    CHECK(string(ca.error().detail) == "argument too long");
+  }
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+TEST_CASE("opportunistic: unknown long options", "[opportunistic]") {
+  CheckArg ca("test19");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+
+  vector<string> argv = {
+    "/test19", "--plugin.size=10", "-v", "--flag", "file", "--output", "out", "--plugin.size=20"};
+  CHECK(ca.parse(argv) == CA_INVOPT);
+
+  ca.set_opportunistic(true);
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.isset("verbose"));
+  CHECK(ca.value("output") == "out");
+  CHECK(ca.pos_args() == vector<string>{"file"});
+
+  // the last one wins
+  CHECK(ca.isset("plugin.size"));
+  CHECK(ca.value("plugin.size") == "20");
+  CHECK(ca.isset("flag"));
+  CHECK(ca.value("flag").empty());
+  CHECK(!ca.isset("other"));
+
+  auto adhoc = ca.adhoc_options();
+  REQUIRE(adhoc.size() == 2);
+  CHECK(adhoc[0].first == "plugin.size");
+  CHECK(adhoc[1].first == "flag");
+
+  // unknown short options are still errors
+  vector<string> short_opt = {"/test19", "-x"};
+  CHECK(ca.parse(short_opt) == CA_INVOPT);
+
+  // a reparse starts empty
+  vector<string> other = {"/test19", "--other"};
+  REQUIRE(ca.parse(other) == CA_ALLOK);
+  CHECK(ca.adhoc_options().size() == 1);
+  CHECK(!ca.isset("plugin.size"));
+  CHECK(ca.isset("other"));
+}
+
+TEST_CASE("opportunistic: options outlive argv", "[opportunistic]") {
+  CheckArg ca("test19");
+  ca.add('v', "verbose", "be verbose");
+  ca.set_opportunistic(true);
+
+  {
+    vector<string> argv = {"/test19", "--plugin.size=10", "--flag"};
+    REQUIRE(ca.parse(argv) == CA_ALLOK);
+  }
+  CHECK(!ca.isset("verbose"));
+  CHECK(ca.value("plugin.size") == "10");
+  CHECK(ca.isset("flag"));
+  REQUIRE(ca.adhoc_options().size() == 2);
+  CHECK(ca.adhoc_options()[1].first == "flag");
+}
+
+TEST_CASE("opportunistic: thousands of keys", "[opportunistic]") {
+  CheckArg ca("test19");
+  ca.set_opportunistic(true);
+
+  vector<string> argv = {"/test19"};
+  for (int i = 0; i < 5000; ++i)
+    argv.push_back("--key-" + std::to_string(i) + "=value-" + std::to_string(i));
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  REQUIRE(ca.adhoc_options().size() == 5000);
+
+  for (int i = 0; i < 5000; i += 7) {
+    INFO("key " << i);
+    CHECK(ca.value("key-" + std::to_string(i)) == "value-" + std::to_string(i));
+  }
+  CHECK(!ca.isset("key-5000"));
+
+  // a warmed-up reparse doesn't allocate
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+  CHECK(ca.value("key-4999") == "value-4999");
+}
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// a fresh directory, removed again at the end of the test
+struct CacheDir {
+  fs::path path;
+  CacheDir() {
+    path = fs::temp_directory_path() / ("checkarg_test20_" + std::to_string(::rand()));
+    fs::remove_all(path);
+    fs::create_directories(path);
+  }
+  ~CacheDir() { fs::remove_all(path); }
+
+  vector<fs::path> records() const {
+    vector<fs::path> found;
+    for (auto &entry : fs::directory_iterator(path)) found.push_back(entry.path());
+    return found;
+  }
+};
+
+}  // namespace
+
+
+TEST_CASE("cache: a hit skips callbacks", "[cache]") {
+  CacheDir dir;
+  int calls = 0;
+  auto normalize = [&calls](CheckArg *const ca, const string &opt, const string &val) {
+    ++calls;
+    return ca->set_value(opt, "/abs/" + val);
+  };
+
+  CheckArg ca("test20");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('o', "output", "output file", normalize, CA_VT_REQUIRED);
+  ca.set_cache_dir(dir.path.string());
+
+  vector<string> argv = {"/test20", "-v", "--output", "out", "file", "--", "-x"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(calls == 1);
+  CHECK(ca.value("output") == "/abs/out");
+  REQUIRE(dir.records().size() == 1);
+  // it holds argv, so only we may read it
+  auto perms = fs::status(dir.records()[0]).permissions();
+  CHECK(perms == (fs::perms::owner_read | fs::perms::owner_write));
+
+  // a second parse, even in a new CheckArg, comes from the record
+  CheckArg ca2("test20");
+  ca2.add('v', "verbose", "be verbose");
+  ca2.add('o', "output", "output file", normalize, CA_VT_REQUIRED);
+  ca2.set_cache_dir(dir.path.string());
+  REQUIRE(ca2.parse(argv) == CA_ALLOK);
+  CHECK(calls == 1);
+  CHECK(ca2.isset("verbose"));
+  CHECK(ca2.value("output") == "/abs/out");
+  CHECK(ca2.pos_args() == vector<string>{"file", "-x"});
+
+  // another argv is another record
+  REQUIRE(ca2.parse(vector<string>{"/test20", "-o", "other"}) == CA_ALLOK);
+  CHECK(calls == 2);
+  CHECK(!ca2.isset("verbose"));
+  CHECK(ca2.value("output") == "/abs/other");
+  CHECK(dir.records().size() == 2);
+
+  // failed parses are not cached
+  CHECK(ca2.parse(vector<string>{"/test20", "-o"}) == CA_MISSVAL);
+  CHECK(dir.records().size() == 2);
+}
+
+TEST_CASE("cache: records of other options are not used", "[cache]") {
+  CacheDir dir;
+  vector<string> argv = {"/test20", "-v", "file"};
+
+  CheckArg ca("test20");
+  ca.add('v', "verbose", "be verbose");
+  ca.set_cache_dir(dir.path.string());
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+
+  // -v now takes a value
+  CheckArg ca2("test20");
+  ca2.add('v', "verbose", "be verbose", CA_VT_REQUIRED);
+  ca2.set_cache_dir(dir.path.string());
+  REQUIRE(ca2.parse(argv) == CA_ALLOK);
+  CHECK(ca2.value("verbose") == "file");
+  CHECK(ca2.pos_args().empty());
+  CHECK(dir.records().size() == 2);
+}
+
+TEST_CASE("cache: broken records are ignored", "[cache]") {
+  CacheDir dir;
+  int calls = 0;
+  auto count = [&calls](CheckArg *const, const string &, const string &) {
+    ++calls;
+    return 0;
+  };
+  vector<string> argv = {"/test20", "--name=x", "file"};
+
+  CheckArg ca("test20");
+  ca.add("name", "some name", count, CA_VT_REQUIRED);
+  ca.set_cache_dir(dir.path.string());
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  REQUIRE(dir.records().size() == 1);
+  auto record = dir.records()[0];
+  auto size   = fs::file_size(record);
+
+  fs::resize_file(record, size - 1);
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(calls == 2);
+  CHECK(ca.value("name") == "x");
+  CHECK(ca.pos_args() == vector<string>{"file"});
+  CHECK(fs::file_size(record) == size);  // written again
+
+  {
+    std::ofstream file(record, std::ios::binary | std::ios::trunc);
+    file << "garbage";
+  }
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(calls == 3);
+  CHECK(ca.value("name") == "x");
+
+  // and now it is a hit again
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(calls == 3);
+  CHECK(ca.value("name") == "x");
+}
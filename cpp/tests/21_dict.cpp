@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+TEST_CASE("dict: key value options", "[dict]") {
+  vector<string> seen;
+  auto cb = [&seen](CheckArg *const, const string &, const string &val) {
+    seen.push_back(val);
+    return 0;
+  };
+
+  CheckArg ca("test21");
+  ca.add('D', "define", "define a macro", CA_VT_DICT);
+  ca.add("set", "set a key", cb, CA_VT_DICT);
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+
+  vector<string> argv = {
+    "/test21", "-DNAME=VALUE", "-D", "EMPTY=", "--define=FLAG", "--set", "a.b=c=d",
+    "-o", "out", "--define", "NAME=other", "--set=x=1", "file"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.value("output") == "out");
+  CHECK(ca.pos_args() == vector<string>{"file"});
+
+  CHECK(ca.isset("define"));
+  CHECK(ca.value("define", "NAME") == "other");  // the last one wins
+  CHECK(ca.value("define", "EMPTY").empty());
+  CHECK(ca.value("define", "missing").empty());
+  auto defines = ca.dict("define");
+  REQUIRE(defines.size() == 3);
+  CHECK(defines[0] == std::pair<std::string_view, std::string_view>{"NAME", "other"});
+  CHECK(defines[1].first == "EMPTY");
+  CHECK(defines[2] == std::pair<std::string_view, std::string_view>{"FLAG", ""});
+
+  // split at the first '=', callbacks see every occurrence
+  CHECK(ca.value("set", "a.b") == "c=d");
+  CHECK(ca.value("set", "x") == "1");
+  CHECK(seen == vector<string>{"a.b=c=d", "x=1"});
+
+  // no dict options
+  CHECK(ca.value("output", "out").empty());
+  CHECK(ca.dict("output").empty());
+  CHECK(ca.dict("unknown").empty());
+  CHECK(ca.set_value("define", "A=B") == CA_INVVAL);
+
+  // a reparse starts empty
+  REQUIRE(ca.parse(vector<string>{"/test21", "-DOTHER"}) == CA_ALLOK);
+  CHECK(ca.dict("define").size() == 1);
+  CHECK(ca.value("define", "NAME").empty());
+  CHECK(!ca.isset("set"));
+  CHECK(ca.dict("set").empty());
+
+  CHECK(ca.parse(vector<string>{"/test21", "-D"}) == CA_MISSVAL);
+}
+
+TEST_CASE("dict: thousands of defines", "[dict]") {
+  CheckArg ca("test21");
+  ca.add('D', "define", "define a macro", CA_VT_DICT);
+
+  vector<string> argv = {"/test21"};
+  for (int i = 0; i < 5000; ++i)
+    argv.push_back("-DNAME_" + std::to_string(i) + "=" + std::to_string(i));
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  REQUIRE(ca.dict("define").size() == 5000);
+  for (int i = 0; i < 5000; i += 7) {
+    INFO("key " << i);
+    CHECK(ca.value("define", "NAME_" + std::to_string(i)) == std::to_string(i));
+  }
+
+  // a warmed-up reparse doesn't allocate
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+  CHECK(ca.value("define", "NAME_4999") == "4999");
+}
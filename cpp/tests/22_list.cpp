@@ -0,0 +1,92 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+namespace {
+
+vector<string>
+to_strings(std::span<const std::string_view> views) {
+  return {views.begin(), views.end()};
+}
+
+}  // namespace
+
+
+TEST_CASE("list: split values", "[list]") {
+  static constexpr checkarg::OptSpec specs[] = {
+    {.sopt = 'p', .lopt = "path", .help = "search path", .value_type = CA_VT_LIST,
+     .delimiter = ':'},
+  };
+
+  CheckArg ca("test22");
+  ca.add('t', "tags", "tags to use", CA_VT_LIST);
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+  ca.add_all(specs);
+
+  vector<string> argv = {
+    "/test22", "--tags=a,b,c", "-t", "d", "-ta,,e", "--path", "/bin:/usr/bin", "file",
+    "--tags", ""};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(to_strings(ca.values("tags")) == vector<string>{"a", "b", "c", "d", "a", "", "e"});
+  CHECK(to_strings(ca.values("path")) == vector<string>{"/bin", "/usr/bin"});
+  CHECK(ca.value("tags").empty());  // the last one given
+  CHECK(ca.pos_args() == vector<string>{"file"});
+
+  CHECK(ca.values("output").empty());
+  CHECK(ca.values("unknown").empty());
+
+  CHECK(ca.set_delimiter("tags", ';') == CA_ALLOK);
+  CHECK(ca.set_delimiter("output", ';') == CA_INVVAL);
+  CHECK(ca.set_delimiter("unknown", ';') == CA_INVOPT);
+  argv = {"/test22", "--tags=a,b;c"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(to_strings(ca.values("tags")) == vector<string>{"a,b", "c"});
+  CHECK(ca.values("path").empty());
+}
+
+TEST_CASE("list: every length and position", "[list]") {
+  CheckArg ca("test22");
+  ca.add("tags", "tags to use", CA_VT_LIST);
+
+  // around the sizes of vector registers, with delimiters everywhere
+  for (size_t size = 0; size < 80; ++size) {
+    for (size_t step = 1; step < 40; step += 3) {
+      string value(size, 'x');
+      vector<string> expected;
+      size_t start = 0;
+      for (size_t i = step - 1; i < size; i += step) {
+        value[i] = ',';
+        expected.push_back(value.substr(start, i - start));
+        start = i + 1;
+      }
+      if (size) expected.push_back(value.substr(start));
+
+      INFO("size " << size << ", step " << step);
+      vector<string> argv = {"/test22", "--tags=" + value};  // the items borrow from it
+      REQUIRE(ca.parse(argv) == CA_ALLOK);
+      CHECK(to_strings(ca.values("tags")) == expected);
+    }
+  }
+}
+
+TEST_CASE("list: huge lists", "[list]") {
+  CheckArg ca("test22");
+  ca.add("tags", "tags to use", CA_VT_LIST);
+
+  string tags = "--tags=";
+  for (int i = 0; i < 50000; ++i) tags += "tag" + std::to_string(i) + ',';
+  tags.pop_back();
+  vector<string> argv = {"/test22", tags};
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  auto items = ca.values("tags");
+  REQUIRE(items.size() == 50000);
+  CHECK(items[0] == "tag0");
+  CHECK(items[31337] == "tag31337");
+  CHECK(items[49999] == "tag49999");
+
+  // a warmed-up reparse doesn't allocate
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+  CHECK(ca.values("tags").size() == 50000);
+}
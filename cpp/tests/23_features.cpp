@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+#include <atomic>
+#include <thread>
+
+
+TEST_CASE("features: enable and disable", "[features]") {
+  CheckArg ca("test23");
+  ca.add('v', "verbose", "be verbose");
+  REQUIRE(ca.add_feature_options() == CA_ALLOK);
+  auto fast   = ca.add_feature("FastPath");
+  auto cache  = ca.add_feature("Cache", true);
+  auto legacy = ca.add_feature("Legacy", true);
+  auto other  = ca.add_feature("Other");
+
+  // the defaults hold before parsing, too
+  CHECK(!fast.enabled());
+  CHECK(cache.enabled());
+  CHECK(fast.id() == 0);
+  CHECK(other.id() == 3);
+
+  vector<string> argv = {
+    "/test23", "--enable-features=FastPath,Other", "-v", "--disable-features", "Legacy",
+    "--disable-features=Other"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.isset("verbose"));
+  CHECK(fast.enabled());
+  CHECK(cache);
+  CHECK(!legacy);
+  CHECK(!other);  // disabling wins
+  CHECK(ca.enabled("FastPath"));
+  CHECK(!ca.enabled("Legacy"));
+  CHECK(!ca.enabled("Unknown"));
+
+  // a reparse starts from the defaults
+  REQUIRE(ca.parse(vector<string>{"/test23"}) == CA_ALLOK);
+  CHECK(!fast);
+  CHECK(legacy);
+
+  // adding again gives the same feature
+  auto fast2 = ca.add_feature("FastPath", true);
+  CHECK(fast2.id() == fast.id());
+  CHECK(fast);
+
+  argv = {"/test23", "--enable-features=Cache,Unknown"};
+  CHECK(ca.parse(argv) == CA_INVFEATURE);
+  CHECK(ca.error().option == "Unknown");
+  CHECK(ca.error().index == 1);
+  CHECK(ca.error().offset == 24);
+  CHECK(ca.error_message() == "Unknown feature: Unknown!");
+  CHECK(fast);  // back at the defaults
+
+  argv = {"/test23", "-v", "--disable-features", "Legacy,Bad", "--enable-features=Other"};
+  CHECK(ca.parse(argv) == CA_INVFEATURE);
+  CHECK(ca.error().option == "Bad");
+  CHECK(ca.error().index == 3);
+  CHECK(ca.error().offset == 7);
+
+  checkarg::FeatureHandle none;
+  CHECK(!none.enabled());
+}
+
+TEST_CASE("features: thousands of features", "[features]") {
+  CheckArg ca("test23");
+  ca.add_feature_options("features", "no-features");
+
+  vector<checkarg::FeatureHandle> handles;
+  for (int i = 0; i < 3000; ++i) handles.push_back(ca.add_feature("F" + std::to_string(i)));
+
+  string enable = "--features=";
+  for (int i = 0; i < 3000; i += 3) enable += "F" + std::to_string(i) + ',';
+  enable.pop_back();
+  vector<string> argv = {"/test23", enable, "--no-features=F2999,F6"};
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  for (int i = 0; i < 3000; ++i) {
+    INFO("feature " << i);
+    CHECK(handles[i].enabled() == (i % 3 == 0 && i != 6 && i != 2999));
+  }
+
+  // a warmed-up reparse doesn't allocate
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+  CHECK(handles[2997]);
+}
+
+TEST_CASE("features: read while reparsing", "[features]") {
+  CheckArg ca("test23");
+  ca.add_feature_options();
+  auto fast = ca.add_feature("FastPath");
+
+  vector<string> argv = {"/test23", "--enable-features=FastPath"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  std::atomic<bool> done = false;
+  std::atomic<int> seen_off = 0;
+  std::thread reader([&] {
+    while (!done.load())
+      if (!fast.enabled()) ++seen_off;
+  });
+  for (int i = 0; i < 1000; ++i) REQUIRE(ca.parse(argv) == CA_ALLOK);
+  done = true;
+  reader.join();
+
+  // a reparse doesn't go through the defaults where others can see them
+  CHECK(seen_off == 0);
+}
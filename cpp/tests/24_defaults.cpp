@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+TEST_CASE("defaults: values of options not given", "[defaults]") {
+  static constexpr checkarg::OptSpec specs[] = {
+    {.lopt = "level", .help = "level to use", .value_type = CA_VT_REQUIRED,
+     .default_value = "3"},
+    {.lopt = "empty", .help = "empty default", .value_type = CA_VT_REQUIRED,
+     .default_value = ""},
+  };
+
+  CheckArg ca("test24");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+  ca.add('i', "input", "input file", CA_VT_REQUIRED);
+  ca.add_all(specs);
+  CHECK(ca.set_default("output", "out.txt") == CA_ALLOK);
+  CHECK(ca.set_default("verbose", "1") == CA_INVVAL);
+  CHECK(ca.set_default("unknown", "1") == CA_INVOPT);
+
+  checkarg::Flag<long> level;
+  REQUIRE(ca.bind("level", level) == CA_ALLOK);
+
+  REQUIRE(ca.parse(vector<string>{"/test24", "-i", "in"}) == CA_ALLOK);
+  CHECK(ca.value("output") == "out.txt");
+  CHECK(ca.value("input") == "in");
+  CHECK(ca.value("level") == "3");
+  CHECK(ca.value_view("empty").empty());
+  CHECK(ca.value_view("empty").data() != nullptr);
+  CHECK(ca.value_view("verbose").empty());
+  CHECK(ca.value_view("unknown").empty());
+  CHECK(level == 3);
+
+  // defaults don't count as given
+  CHECK(!ca.isset("output"));
+  CHECK(!ca.isset("level"));
+
+  // a given value wins
+  vector<string> argv = {"/test24", "--output=other", "--level", "5"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.value_view("output") == "other");
+  CHECK(level == 5);
+
+  // the default is a view of the one copy kept
+  REQUIRE(ca.parse(vector<string>{"/test24"}) == CA_ALLOK);
+  auto view = ca.value_view("output");
+  REQUIRE(ca.parse(vector<string>{"/test24"}) == CA_ALLOK);
+  CHECK(ca.value_view("output").data() == view.data());
+  CHECK(level == 3);
+
+  auto help = ca.autohelp();
+  CHECK(help.find("output file (default: out.txt)") != string::npos);
+  CHECK(help.find("level to use (default: 3)") != string::npos);
+  CHECK(help.find("input file\n") != string::npos);
+}
+
+TEST_CASE("defaults: reparses don't copy them", "[defaults]") {
+  CheckArg ca("test24");
+  vector<string> names;
+  for (int i = 0; i < 500; ++i) names.push_back("option-" + std::to_string(i));
+  for (auto &name : names) {
+    ca.add(name, "some option", CA_VT_REQUIRED);
+    ca.set_default(name, "a default value too long for the small string buffer");
+  }
+
+  vector<string> argv = {"/test24", "--option-7=x"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(alloc_count::count([&] {
+          for (int i = 0; i < 100; ++i) REQUIRE(ca.parse(argv) == CA_ALLOK);
+        })
+        == 0);
+  CHECK(ca.value_view("option-7") == "x");
+  CHECK(ca.value_view("option-8") == "a default value too long for the small string buffer");
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+
+TEST_CASE("constraints: required, conflicts and requires", "[constraints]") {
+  CheckArg ca("test25");
+  ca.set_print_errors(false);
+  ca.add('i', "input", "input file", CA_VT_REQUIRED);
+  ca.add('j', "json", "write json");
+  ca.add('x', "xml", "write xml");
+  ca.add('y', "yaml", "write yaml");
+  ca.add('p', "pretty", "pretty print");
+  ca.add('v', "verbose", "be verbose");
+
+  REQUIRE(ca.add_required("input") == CA_ALLOK);
+  REQUIRE(ca.add_conflict({"json", "xml", "yaml"}) == CA_ALLOK);
+  REQUIRE(ca.add_requires("pretty", "json") == CA_ALLOK);
+  CHECK(ca.add_required("unknown") == CA_INVOPT);
+  CHECK(ca.add_conflict({"json", "unknown"}) == CA_INVOPT);
+  CHECK(ca.add_conflict({"json"}) == CA_ERROR);
+  CHECK(ca.add_requires("pretty", "unknown") == CA_INVOPT);
+
+  CHECK(ca.parse(vector<string>{"/test25", "-i", "in", "-jp"}) == CA_ALLOK);
+  CHECK(ca.parse(vector<string>{"/test25", "-i", "in", "-y"}) == CA_ALLOK);
+  CHECK(ca.parse(vector<string>{"/test25", "-i", "in"}) == CA_ALLOK);
+
+  REQUIRE(ca.parse(vector<string>{"/test25", "-j"}) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 0);
+  CHECK(ca.error().option == "input");
+  CHECK(ca.error_message() == "Option constraint violated: --input is required!");
+
+  REQUIRE(ca.parse(vector<string>{"/test25", "-i", "in", "-yj"}) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 1);
+  CHECK((ca.error().option == "json" || ca.error().option == "yaml"));
+  CHECK(
+    ca.error_message()
+    == "Option constraint violated: only one of --json, --xml, --yaml may be given!");
+
+  REQUIRE(ca.parse(vector<string>{"/test25", "-i", "in", "-xp"}) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 2);
+  CHECK(ca.error().option == "pretty");
+  CHECK(ca.error_message() == "Option constraint violated: --pretty requires --json!");
+
+  // constraints added later count, too
+  REQUIRE(ca.add_requires("verbose", "pretty") == CA_ALLOK);
+  REQUIRE(ca.parse(vector<string>{"/test25", "-i", "in", "-v"}) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 3);
+}
+
+TEST_CASE("constraints: many options", "[constraints]") {
+  CheckArg ca("test25");
+  ca.set_print_errors(false);
+  vector<string> names;
+  for (int i = 0; i < 300; ++i) names.push_back("option-" + std::to_string(i));
+  for (auto &name : names) ca.add(name, "some option");
+
+  // spanning several words of the presence bitset
+  REQUIRE(ca.add_conflict({"option-3", "option-150", "option-299"}) == CA_ALLOK);
+  for (int i = 0; i < 300; i += 10)
+    REQUIRE(ca.add_requires(names[i], names[i + 1]) == CA_ALLOK);
+  REQUIRE(ca.add_required("option-200") == CA_ALLOK);
+
+  vector<string> argv = {"/test25", "--option-200", "--option-299"};
+  REQUIRE(ca.parse(argv) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 21);
+  CHECK(ca.error().option == "option-200");
+
+  vector<string> good = {"/test25", "--option-200", "--option-201", "--option-299"};
+  REQUIRE(ca.parse(good) == CA_ALLOK);
+
+  vector<string> bad = {
+    "/test25", "--option-200", "--option-201", "--option-299", "--option-3"};
+  REQUIRE(ca.parse(bad) == CA_CONSTRAINT);
+  CHECK(ca.error().rule == 0);
+  CHECK(ca.error().option == "option-299");
+
+  // a warmed-up check doesn't allocate
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(good) == CA_ALLOK); }) == 0);
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(bad) == CA_CONSTRAINT); }) == 0);
+}
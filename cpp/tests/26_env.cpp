@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+#include <cstdlib>
+
+
+TEST_CASE("env: bound variables", "[env]") {
+  setenv("TEST26_THREADS", "8", 1);
+  setenv("TEST26_VERBOSE", "1", 1);
+  setenv("TEST26_QUIET", "0", 1);
+  unsetenv("TEST26_UNSET");
+
+  CheckArg ca("test26");
+  ca.add('t', "threads", "number of threads", CA_VT_REQUIRED);
+  ca.add('v', "verbose", "be verbose");
+  ca.add('q', "quiet", "be quiet");
+  ca.add('o', "output", "output file", CA_VT_REQUIRED);
+  ca.add("tags", "some tags", CA_VT_LIST);
+  REQUIRE(ca.bind_env("threads", "TEST26_THREADS") == CA_ALLOK);
+  REQUIRE(ca.bind_env("verbose", "TEST26_VERBOSE") == CA_ALLOK);
+  REQUIRE(ca.bind_env("quiet", "TEST26_QUIET") == CA_ALLOK);
+  REQUIRE(ca.bind_env("output", "TEST26_UNSET") == CA_ALLOK);
+  CHECK(ca.bind_env("unknown", "TEST26_X") == CA_INVOPT);
+  CHECK(ca.bind_env("tags", "TEST26_X") == CA_INVVAL);
+
+  checkarg::Flag<int> threads;
+  REQUIRE(ca.bind("threads", threads) == CA_ALLOK);
+
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(ca.isset("threads"));
+  CHECK(ca.value("threads") == "8");
+  CHECK(threads == 8);
+  CHECK(ca.isset("verbose"));
+  CHECK(!ca.isset("quiet"));  // "0" is off
+  CHECK(!ca.isset("output"));
+
+  // the command line wins
+  vector<string> argv = {"/test26", "--threads=2"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.value("threads") == "2");
+  CHECK(threads == 2);
+
+  // a view into the environment, not a copy
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(ca.value_view("threads").data() == getenv("TEST26_THREADS"));
+
+  // an environment satisfies constraints
+  REQUIRE(ca.add_required("threads") == CA_ALLOK);
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  unsetenv("TEST26_THREADS");
+  CHECK(ca.parse(vector<string>{"/test26"}) == CA_CONSTRAINT);
+}
+
+TEST_CASE("env: prefixed variables", "[env]") {
+  setenv("TEST26P_OUTPUT_FORMAT", "json", 1);
+  setenv("TEST26P_LEVEL", "prefixed", 1);
+  setenv("TEST26_LEVEL", "bound", 1);
+  setenv("TEST26P_UNKNOWN", "x", 1);
+  setenv("TEST26P_", "x", 1);
+
+  CheckArg ca("test26");
+  ca.add("output-format", "format to write", CA_VT_REQUIRED);
+  ca.add("level", "some level", CA_VT_REQUIRED);
+  ca.set_env_prefix("TEST26P_");
+
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(ca.value("output-format") == "json");
+  CHECK(ca.value("level") == "prefixed");
+
+  // the variable's case doesn't matter, the long option's does, like in C
+  setenv("TEST26P_Mixed_CASE", "mixed", 1);
+  setenv("TEST26P_UPPER", "upper", 1);
+  ca.add("mixed-case", "in the variable", CA_VT_REQUIRED);
+  ca.add("Upper", "in the option", CA_VT_REQUIRED);
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(ca.value("mixed-case") == "mixed");
+  CHECK(!ca.isset("Upper"));
+
+  // a bound variable wins
+  REQUIRE(ca.bind_env("level", "TEST26_LEVEL") == CA_ALLOK);
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(ca.value("level") == "bound");
+
+  // a warmed-up parse doesn't allocate
+  vector<string> argv = {"/test26", "--output-format=xml"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(alloc_count::count([&] { REQUIRE(ca.parse(argv) == CA_ALLOK); }) == 0);
+  CHECK(ca.value("output-format") == "xml");
+
+  ca.set_env_prefix("");
+  unsetenv("TEST26_LEVEL");
+  REQUIRE(ca.parse(vector<string>{"/test26"}) == CA_ALLOK);
+  CHECK(!ca.isset("output-format"));
+  CHECK(!ca.isset("level"));
+}
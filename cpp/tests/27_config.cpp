@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "checkargpp_config.hpp"
+#include "test.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <thread>
+
+#include <unistd.h>
+
+namespace {
+
+std::map<string, string> called;
+
+int
+record(CheckArg *const, const string &lopt, const string &value) {
+  called[lopt] = value;
+  return CA_ALLOK;
+}
+
+void
+write_file(const string &path, const string &text) {
+  std::ofstream(path, std::ios::trunc) << text;
+}
+
+string
+temp_dir() {
+  char dir[] = "/tmp/test27.XXXXXX";
+  REQUIRE(mkdtemp(dir));
+  return dir;
+}
+
+}  // namespace
+
+TEST_CASE("config: incremental reload", "[config]") {
+  auto dir  = temp_dir();
+  auto path = dir + "/app.conf";
+  write_file(path, "# settings\nthreads = 4\nlevel=debug\nverbose\n\noutput = a.txt\n");
+
+  CheckArg ca("test27");
+  ca.add('t', "threads", "number of threads", record, CA_VT_REQUIRED);
+  ca.add('l', "level", "log level", record, CA_VT_REQUIRED);
+  ca.add('v', "verbose", "be verbose", record);
+  ca.add('o', "output", "output file", record, CA_VT_REQUIRED);
+  checkarg::Flag<int> threads(1);
+  checkarg::Flag<std::string> level("info");
+  REQUIRE(ca.bind("threads", threads) == CA_ALLOK);
+  REQUIRE(ca.bind("level", level) == CA_ALLOK);
+  vector<string> argv = {"/test27", "--level=warn"};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+
+  called.clear();
+  checkarg::ConfigSource source;
+  REQUIRE(source.start(ca, path) == CA_ALLOK);
+  auto snap = source.snapshot();
+  REQUIRE(snap);
+  CHECK(snap->version() == 1);
+  CHECK(snap->value("threads") == "4");
+  CHECK(snap->value("output") == "a.txt");
+  CHECK(snap->isset("verbose"));
+  CHECK(called.size() == 4);
+  CHECK(threads == 4);
+  CHECK(*level.get() == "warn");  // the command line wins
+  CHECK(!ca.isset("threads"));     // only the command line and environment
+  source.stop();  // reloaded by hand from here on
+
+  // only the changed line is tokenized and only its callback called
+  called.clear();
+  write_file(path, "# settings\nthreads = 8\nlevel=debug\nverbose\n\noutput = a.txt\n");
+  REQUIRE(source.reload() == CA_ALLOK);
+  snap = source.snapshot();
+  CHECK(snap->lines_tokenized() == 1);
+  CHECK(called == std::map<string, string>{{"threads", "8"}});
+  CHECK(snap->value("output") == "a.txt");
+  CHECK(threads == 8);
+
+  // removing an option restores its flag
+  called.clear();
+  write_file(path, "# settings\nlevel=debug\nverbose\n\noutput = a.txt\n");
+  REQUIRE(source.reload() == CA_ALLOK);
+  CHECK(called == std::map<string, string>{{"threads", ""}});
+  CHECK(!source.snapshot()->isset("threads"));
+  CHECK(threads == 1);
+
+  // a broken file is not applied
+  auto version = source.snapshot()->version();
+  write_file(path, "# settings\nlevel=debug\nverbose = yes\n\noutput = a.txt\n");
+  CHECK(source.reload() == CA_INVVAL);
+  CHECK(source.error().option == "verbose");
+  CHECK(source.error().index == 3);
+  write_file(path, "# settings\nlevel=debug\nunknown\n\noutput = a.txt\n");
+  CHECK(source.reload() == CA_INVOPT);
+  write_file(path, "threads = many\n");
+  CHECK(source.reload() == CA_BADVAL);
+  CHECK(source.snapshot()->version() == version);
+  CHECK(threads == 1);
+
+  // the watcher picks up a file replaced by a rename
+  write_file(path, "threads = 2\nlevel=debug\nverbose\n\noutput = a.txt\n");
+  REQUIRE(source.start(ca, path) == CA_ALLOK);
+  version = source.snapshot()->version();
+  called.clear();
+  write_file(path + ".new", "threads = 16\nlevel=debug\nverbose\n\noutput = a.txt\n");
+  REQUIRE(std::rename((path + ".new").c_str(), path.c_str()) == 0);
+  auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (source.snapshot()->version() == version
+         && std::chrono::steady_clock::now() < until)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  source.stop();
+  CHECK(source.snapshot()->version() == version + 1);
+  CHECK(threads == 16);
+
+  // callbacks are left for the caller's thread
+  CHECK(called.empty());
+  CHECK(source.poll() == CA_ALLOK);
+  CHECK(called == std::map<string, string>{{"threads", "16"}});
+  called.clear();
+  CHECK(source.poll() == CA_ALLOK);
+  CHECK(called.empty());
+
+  std::remove(path.c_str());
+  rmdir(dir.c_str());
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "alloc_count.hpp"
+#include "test.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+
+#include <unistd.h>
+
+namespace {
+
+string
+temp_file(const string &text) {
+  char path[] = "/tmp/test28.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  std::ofstream(path, std::ios::trunc) << text;
+  return path;
+}
+
+}  // namespace
+
+TEST_CASE("file: contents of file options", "[file]") {
+  auto words = temp_file("apple\nbanana\ncherry\n");
+  auto empty = temp_file("");
+
+  CheckArg ca("test28");
+  ca.add('d', "dict", "word list", CA_VT_FILE);
+  ca.add("cert", "certificate", CA_VT_FILE);
+  ca.add("key", "private key", CA_VT_FILE);
+  ca.add("name", "a name", CA_VT_REQUIRED);
+  REQUIRE(ca.set_default("key", "/nonexistent/test28.key") == CA_ALLOK);
+
+  vector<string> argv = {"/test28", "--dict=@" + words, "--cert", empty};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.value("dict") == "@" + words);
+
+  std::span<const char> contents;
+  REQUIRE(ca.file("dict", contents) == CA_ALLOK);
+  CHECK(string(contents.begin(), contents.end()) == "apple\nbanana\ncherry\n");
+
+  // mapped once, asking again gives the same memory without allocating
+  std::span<const char> again;
+  CHECK(alloc_count::count([&] { REQUIRE(ca.file("dict", again) == CA_ALLOK); }) == 0);
+  CHECK(again.data() == contents.data());
+  CHECK(again.size() == contents.size());
+
+  // the same file given without '@' is the same mapping
+  vector<string> argv2 = {"/test28", "-d", words};
+  REQUIRE(ca.parse(argv2) == CA_ALLOK);
+  REQUIRE(ca.file("dict", again) == CA_ALLOK);
+  CHECK(again.data() == contents.data());
+
+  // and it stays valid after another parse
+  CHECK(string(contents.begin(), contents.end()) == "apple\nbanana\ncherry\n");
+
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  REQUIRE(ca.file("cert", contents) == CA_ALLOK);
+  CHECK(contents.empty());
+
+  // a default is only opened when asked for
+  errno = 0;
+  CHECK(ca.file("key", contents) == CA_ERROR);
+  CHECK(errno == ENOENT);
+
+  CHECK(ca.file("unknown", contents) == CA_INVOPT);
+  CHECK(ca.file("name", contents) == CA_INVVAL);
+  REQUIRE(ca.parse(vector<string>{"/test28"}) == CA_ALLOK);
+  CHECK(ca.file("dict", contents) == CA_MISSVAL);
+
+  std::remove(words.c_str());
+  std::remove(empty.c_str());
+}
+
+TEST_CASE("file: file options in autohelp", "[file]") {
+  CheckArg ca("test28");
+  ca.add('d', "dict", "word list", CA_VT_FILE, "@FILE");
+  CHECK(ca.autohelp().find("--dict=@FILE") != string::npos);
+}
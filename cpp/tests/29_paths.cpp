@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace checkarg;
+
+namespace {
+
+struct TempDir {
+  string path;
+  TempDir() {
+    char dir[] = "/tmp/test29.XXXXXX";
+    REQUIRE(mkdtemp(dir));
+    path = dir;
+    std::ofstream(path + "/file") << "x";
+    mkdir((path + "/dir").c_str(), 0755);
+  }
+  ~TempDir() {
+    std::remove((path + "/file").c_str());
+    rmdir((path + "/dir").c_str());
+    rmdir(path.c_str());
+  }
+};
+
+}  // namespace
+
+TEST_CASE("paths: options", "[paths]") {
+  TempDir tmp;
+  CheckArg ca("test29");
+  ca.add('i', "input", "input file", CA_VT_REQUIRED);
+  ca.add('o', "outdir", "output directory", CA_VT_REQUIRED);
+  ca.add("dict", "word list", CA_VT_FILE);
+  ca.add("log", "log file", CA_VT_REQUIRED);
+  ca.add('v', "verbose", "be verbose");
+  REQUIRE(ca.set_path_check("input", PC_FILE | PC_READABLE) == CA_ALLOK);
+  REQUIRE(ca.set_path_check("outdir", PC_DIR) == CA_ALLOK);
+  REQUIRE(ca.set_path_check("dict", PC_FILE) == CA_ALLOK);
+  CHECK(ca.set_path_check("verbose", PC_EXISTS) == CA_INVVAL);
+  CHECK(ca.set_path_check("unknown", PC_EXISTS) == CA_INVOPT);
+  ca.set_print_errors(false);
+
+  auto file = tmp.path + "/file", dir = tmp.path + "/dir";
+  vector<string> argv = {"/test29", "-i", file, "--outdir=" + dir, "--dict=@" + file};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  CHECK(ca.path_errors().empty());
+
+  // not given, nothing to check
+  REQUIRE(ca.parse(vector<string>{"/test29"}) == CA_ALLOK);
+
+  vector<string> swapped = {"/test29", "-v", "--input", dir, "-o", file};
+  CHECK(ca.parse(swapped) == CA_PATH);
+  CHECK(ca.error().index == 3);
+  CHECK(ca.error().option == dir);
+  auto message = "Invalid path argument: " + dir + " (not a regular file)!";
+  CHECK(ca.error_message() == message);
+  REQUIRE(ca.path_errors().size() == 2);
+  CHECK(ca.path_errors()[1].index == 5);
+  CHECK(string(ca.path_errors()[1].detail) == "not a directory");
+
+  // defaults are checked too, they have no argv index
+  REQUIRE(ca.set_path_check("log", PC_EXISTS) == CA_ALLOK);
+  REQUIRE(ca.set_default("log", tmp.path + "/missing.log") == CA_ALLOK);
+  CHECK(ca.parse(vector<string>{"/test29"}) == CA_PATH);
+  CHECK(ca.error().index == -1);
+  CHECK(string(ca.error().detail) == "no such file or directory");
+  REQUIRE(ca.set_path_check("log", 0) == CA_ALLOK);
+  CHECK(ca.parse(vector<string>{"/test29"}) == CA_ALLOK);
+}
+
+TEST_CASE("paths: with a parse cache", "[paths]") {
+  TempDir tmp, cache;
+  auto input = tmp.path + "/input";
+  std::ofstream(input) << "x";
+
+  CheckArg ca("test29");
+  ca.add('v', "verbose", "be verbose");
+  ca.add('i', "input", "input file", CA_VT_REQUIRED);
+  REQUIRE(ca.set_path_check("input", PC_FILE) == CA_ALLOK);
+  ca.set_cache_dir(cache.path);
+  ca.set_print_errors(false);
+
+  // a record doesn't know where the path was given, so none is used
+  vector<string> argv = {"/test29", "-v", "--input", input};
+  REQUIRE(ca.parse(argv) == CA_ALLOK);
+  std::remove(input.c_str());
+  CHECK(ca.parse(vector<string>{"/test29", "-i", input}) == CA_PATH);
+  CHECK(ca.error().index == 2);
+  CHECK(ca.parse(argv) == CA_PATH);
+  CHECK(ca.error().index == 3);
+}
+
+TEST_CASE("paths: positional args", "[paths]") {
+  TempDir tmp;
+  auto file = tmp.path + "/file", missing = tmp.path + "/missing";
+
+  CheckArg ca("test29");
+  ca.add('v', "verbose", "be verbose");
+  ca.set_pos_path_check(PC_EXISTS);
+  ca.set_print_errors(false);
+
+  auto dir            = tmp.path + "/dir";
+  vector<string> argv = {"/test29", file, "-v", missing, dir, "--", missing};
+  CHECK(ca.parse(argv) == CA_PATH);
+  CHECK(ca.error().index == 3);
+  REQUIRE(ca.path_errors().size() == 2);
+  CHECK(ca.path_errors()[0].index == 3);
+  CHECK(ca.path_errors()[1].index == 6);
+
+  ca.set_pos_path_check(PC_FILE);
+  vector<string> files = {"/test29", file, dir, file};
+  CHECK(ca.parse(files) == CA_PATH);
+  CHECK(ca.error().index == 2);
+
+  // without collecting them
+  ca.set_lazy_pos_args(true);
+  CHECK(ca.parse(files) == CA_PATH);
+  CHECK(ca.error().index == 2);
+  CHECK(ca.error().option == dir);
+
+  // paths are checked after parsing, so all of them were parsed
+  vector<string> range;
+  for (auto arg : ca.pos_args_range()) range.emplace_back(arg);
+  CHECK(range == vector<string>{file, dir, file});
+}
+
+TEST_CASE("paths: many paths in parallel", "[paths]") {
+  TempDir tmp;
+  auto file = tmp.path + "/file";
+
+  vector<string> argv = {"/test29", "-v"};
+  for (int i = 0; i < 20000; ++i)
+    argv.push_back(i % 5000 == 17 ? "/nonexistent" : file);
+
+  for (unsigned threads : {1u, 4u}) {
+    CheckArg ca("test29");
+    ca.add('v', "verbose", "be verbose");
+    ca.set_pos_path_check(PC_FILE | PC_READABLE);
+    ca.set_parse_threads(threads);
+    ca.set_print_errors(false);
+
+    CHECK(ca.parse(argv) == CA_PATH);
+    CHECK(ca.error().index == 19);
+    REQUIRE(ca.path_errors().size() == 4);
+    for (int k = 0; k < 4; ++k)
+      CHECK(ca.path_errors()[k].index == 2 + k * 5000 + 17);
+    CHECK(ca.pos_args().size() == 20000);
+  }
+}
@@ -0,0 +1,105 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+// parses command lines using a schema with lots of options and long help texts,
+// reporting time and, where perf events are available, cache misses per parse
+#include "checkargpp.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAS_PERF_EVENTS 1
+#endif
+
+using std::string;
+using std::vector;
+
+// counts hardware cache misses of this thread, returns -1 if unavailable
+class CacheMisses {
+public:
+  CacheMisses() {
+#ifdef HAS_PERF_EVENTS
+    perf_event_attr attr{};
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    fd                  = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+  ~CacheMisses() {
+#ifdef HAS_PERF_EVENTS
+    if (fd >= 0) close(fd);
+#endif
+  }
+
+  void start() {
+#ifdef HAS_PERF_EVENTS
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  }
+
+  long long stop() {
+    long long count = -1;
+#ifdef HAS_PERF_EVENTS
+    if (fd < 0 || ioctl(fd, PERF_EVENT_IOC_DISABLE, 0) != 0) return -1;
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+#endif
+    return count;
+  }
+
+private:
+  int fd = -1;
+};
+
+int
+main(int argc, char **argv) {
+  const int options = argc > 1 ? std::stoi(argv[1]) : 5000;
+  const int given   = argc > 2 ? std::stoi(argv[2]) : 500;
+  const int rounds  = argc > 3 ? std::stoi(argv[3]) : 2000;
+
+  CheckArg ca("bench_large_schema");
+  for (int i = 0; i < options; ++i) {
+    string lopt = "option-" + std::to_string(i);
+    string help = "help text of " + lopt + ", " + string(200, 'x');
+    ca.add(lopt, help, i % 2 ? CA_VT_REQUIRED : CA_VT_NONE, "VALUE");
+  }
+
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> pick(0, options - 1);
+  vector<string> args = {"/bench_large_schema"};
+  for (int i = 0; i < given; ++i) {
+    int opt = pick(rng);
+    args.push_back("--option-" + std::to_string(opt) + (opt % 2 ? "=value" : ""));
+  }
+
+  if (ca.parse(args) != CA_ALLOK) return 1;  // warm up
+
+  CacheMisses misses;
+  misses.start();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) ca.parse(args);
+  auto end        = std::chrono::steady_clock::now();
+  long long count = misses.stop();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf(
+    "%d options, %d given: %.1f ns/parse", options, given, double(ns) / rounds);
+  if (count >= 0)
+    printf(", %.1f cache misses/parse\n", double(count) / rounds);
+  else
+    printf(", cache misses unavailable\n");
+  return 0;
+}
@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+// parses one huge command line, mostly file names,
+// with different numbers of threads
+#include "checkargpp.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+int
+main(int argc, char **argv) {
+  const int count  = argc > 1 ? std::stoi(argv[1]) : 1000000;
+  const int rounds = argc > 2 ? std::stoi(argv[2]) : 10;
+
+  vector<string> args = {"/bench_parallel"};
+  for (int i = 0; static_cast<int>(args.size()) < count; ++i) {
+    if (i % 100 == 0) args.push_back("--output=out-" + std::to_string(i));
+    else if (i % 100 == 1) args.push_back("-v");
+    else args.push_back("/some/directory/file-" + std::to_string(i) + ".txt");
+  }
+
+  for (unsigned threads : {1u, 2u, 4u, 8u}) {
+    CheckArg ca("bench_parallel");
+    ca.add('v', "verbose", "be verbose");
+    ca.add('o', "output", "output file", CA_VT_REQUIRED);
+    ca.set_parse_threads(threads);
+    if (ca.parse(args) != CA_ALLOK) return 1;  // warm up
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) ca.parse(args);
+    auto end = std::chrono::steady_clock::now();
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    printf(
+      "%zu args, %u threads: %.1f ms/parse\n", args.size(), threads,
+      double(us) / rounds / 1000);
+  }
+  return 0;
+}
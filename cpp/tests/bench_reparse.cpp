@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+// reparses the same command line over and over,
+// reporting time and heap allocations per parse
+#include "alloc_count.hpp"
+#include "checkargpp.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+int
+main(int argc, char **argv) {
+  const int options = argc > 1 ? std::stoi(argv[1]) : 50;
+  const int rounds  = argc > 2 ? std::stoi(argv[2]) : 100000;
+
+  CheckArg ca("bench_reparse");
+  vector<string> args = {"/bench_reparse"};
+  for (int i = 0; i < options; ++i) {
+    string lopt = "option-" + std::to_string(i);
+    if (i % 2) {
+      ca.add(lopt, "help of " + lopt, CA_VT_REQUIRED);
+      args.push_back("--" + lopt + "=value of " + lopt);
+    }
+    else {
+      ca.add(lopt, "help of " + lopt);
+      args.push_back("--" + lopt);
+    }
+    args.push_back("positional-" + std::to_string(i));
+  }
+
+  if (ca.parse(args) != CA_ALLOK) return 1;  // warm up
+
+  alloc_count::start();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; ++i) ca.parse(args);
+  auto end      = std::chrono::steady_clock::now();
+  size_t allocs = alloc_count::stop();
+
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  printf(
+    "%d options, %zu args: %.1f ns/parse, %.2f allocations/parse\n", options,
+    args.size(), double(ns) / rounds, double(allocs) / rounds);
+  return 0;
+}
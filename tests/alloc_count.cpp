@@ -0,0 +1,187 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+
+// Linked into every test binary of the C and C++ libraries, so tests and
+// benchmarks can assert how many heap allocations a piece of code does.
+// With a sanitizer its allocator hooks are used, as it replaces malloc().
+// ThreadSanitizer doesn't call them for aligned_alloc() and posix_memalign().
+// With glibc malloc() and its aligned variants are hooked, which catches
+// operator new, too, since libstdc++ implements it using them.
+// Elsewhere only the global operator new is replaced.
+#include "alloc_count.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <new>
+
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define ALLOC_COUNT_SANITIZER 1
+#endif
+#if __has_feature(thread_sanitizer)
+#define ALLOC_COUNT_SANITIZER 1
+#define ALLOC_COUNT_TSAN 1
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__)
+#define ALLOC_COUNT_SANITIZER 1
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define ALLOC_COUNT_SANITIZER 1
+#define ALLOC_COUNT_TSAN 1
+#endif
+
+#ifdef ALLOC_COUNT_SANITIZER
+// from sanitizer/allocator_interface.h, which not every compiler ships
+extern "C" int __sanitizer_install_malloc_and_free_hooks(
+  void (*malloc_hook)(const volatile void *, size_t),
+  void (*free_hook)(const volatile void *));
+#endif
+
+namespace {
+std::atomic<bool> counting{false};
+std::atomic<size_t> allocations{0};
+std::atomic<size_t> allocated_bytes{0};
+
+inline void
+record(size_t size) {
+  if (counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  }
+}
+}  // namespace
+
+void
+alloc_count::start() {
+  allocations     = 0;
+  allocated_bytes = 0;
+  counting        = true;
+}
+
+size_t
+alloc_count::stop() {
+  counting = false;
+  return allocations;
+}
+
+size_t
+alloc_count::bytes() {
+  return allocated_bytes;
+}
+
+bool
+alloc_count::counts_aligned_malloc() {
+#ifdef ALLOC_COUNT_TSAN
+  return false;
+#else
+  return true;
+#endif
+}
+
+
+#if defined(ALLOC_COUNT_SANITIZER)
+
+namespace {
+void
+on_malloc(const volatile void *, size_t size) {
+  record(size);
+}
+void
+on_free(const volatile void *) {}
+
+// called for every allocation, whichever function did it
+[[maybe_unused]] const int hooked =
+  __sanitizer_install_malloc_and_free_hooks(on_malloc, on_free);
+}  // namespace
+
+#elif defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void *__libc_memalign(size_t, size_t);
+
+void *
+malloc(size_t size) {
+  record(size);
+  return __libc_malloc(size);
+}
+
+void *
+calloc(size_t n, size_t size) {
+  record(n * size);
+  return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *ptr, size_t size) {
+  record(size);
+  return __libc_realloc(ptr, size);
+}
+
+// operator new(size_t, std::align_val_t) uses one of these
+void *
+memalign(size_t alignment, size_t size) {
+  record(size);
+  return __libc_memalign(alignment, size);
+}
+
+void *
+aligned_alloc(size_t alignment, size_t size) {
+  record(size);
+  return __libc_memalign(alignment, size);
+}
+
+int
+posix_memalign(void **ptr, size_t alignment, size_t size) {
+  if (!alignment || alignment % sizeof(void *) || (alignment & (alignment - 1)))
+    return EINVAL;
+  record(size);
+  void *mem = __libc_memalign(alignment, size);
+  if (!mem) return ENOMEM;
+  *ptr = mem;
+  return 0;
+}
+}
+
+#else
+
+void *
+operator new(size_t size) {
+  record(size);
+  if (void *ptr = std::malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+
+void *
+operator new(size_t size, std::align_val_t alignment) {
+  record(size);
+  auto align = static_cast<size_t>(alignment);
+  size       = (size + align - 1) / align * align;  // aligned_alloc wants a multiple
+  if (void *ptr = std::aligned_alloc(align, size ? size : align)) return ptr;
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void *ptr) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void *ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+void
+operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+  std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2021-2022 brainpower <brainpower at mailbox dot org>
+#ifndef ALLOC_COUNT_HPP
+#define ALLOC_COUNT_HPP
+
+#include <cstddef>
+
+// counts heap allocations done by malloc() and operator new,
+// see alloc_count.cpp for how they're hooked
+namespace alloc_count {
+
+void start();
+size_t stop();  // returns the number of allocations since start()
+size_t bytes();  // bytes allocated between the last start() and stop()
+// whether aligned_alloc() and posix_memalign() are counted, not under TSan
+bool counts_aligned_malloc();
+
+// run f and return the number of allocations it did
+template<typename F>
+size_t
+count(F &&f) {
+  start();
+  f();
+  return stop();
+}
+
+}  // namespace alloc_count
+
+#endif  // ALLOC_COUNT_HPP